@@ -0,0 +1,23 @@
+#include <cstdlib>
+#include <new>
+
+// ----------------------------------------------------------------------
+
+  // Counts allocations of the calling thread (benchmarks running threads
+  // do not contend on it), reported per parse by the hot-paths benchmark.
+  // Separate translation unit: if inlined into the benchmarks, gcc -O3
+  // reports free() of the result of operator new as a mismatch.
+thread_local std::size_t sAllocations = 0;
+
+void* operator new(std::size_t aSize)
+{
+    ++sAllocations;
+    if (void* p = std::malloc(aSize == 0 ? 1 : aSize))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* aPtr) noexcept { std::free(aPtr); }
+void operator delete(void* aPtr, std::size_t) noexcept { std::free(aPtr); }
+
+// ----------------------------------------------------------------------
@@ -0,0 +1,960 @@
+#include <chrono>
+#include <functional>
+#include <cstdio>
+#include <thread>
+#include <sstream>
+#include <unistd.h>
+
+#include "command-line-arguments.hh"
+
+// ----------------------------------------------------------------------
+
+void bench_response_file(std::size_t aSizeMb, command_line_arguments::ResponseFiles aMode, bool aStream, bool aKeep);
+std::string generate_response_file(std::size_t aSizeMb, bool aNullSeparated, std::size_t& aTokens, std::size_t& aBytes);
+void bench_batch(std::size_t aLines);
+void bench_shell_line(std::size_t aLines);
+void bench_reject(std::size_t aLines);
+void bench_convert(std::size_t aLines);
+void bench_list();
+void bench_lazy(std::size_t aLines);
+void bench_construct(std::size_t aLines);
+void bench_hot_paths(std::size_t aLines);
+void bench_complete(std::size_t aLines);
+void bench_subcommands(std::size_t aLines);
+void generate_spec(std::size_t aOptions);
+long current_rss_kb();
+
+// ----------------------------------------------------------------------
+
+  // allocations of the calling thread, counted by operator new in bench-allocations.cc
+extern thread_local std::size_t sAllocations;
+
+// ----------------------------------------------------------------------
+
+int main(int argc, const char *argv[])
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::PrintHelp;
+    using command_line_arguments::ResponseFiles;
+
+    auto cl = make_command_line_arguments(
+        Arg<unsigned long>("size-mb", 256UL, Help("size of generated response file in MB")),
+        Arg<bool>("keep", false, Help("do not remove generated files")),
+        Arg<unsigned long>("lines", 1000000UL, Help("number of command lines for batch benchmark")),
+        Arg<unsigned long>("options", 100UL, Help("number of options of the program written by generate-spec")),
+        Arg<PrintHelp>('h', "help", "Usage: {progname} [options] [<benchmark> ...]\nBenchmarks: response-file response-file-0 response-file-stream batch shell-line reject convert list lazy construct hot-paths complete subcommands\n  generate-spec: writes a program with --options options to stdout, see make bench-scaling", Help("print help"))
+                                          );
+    cl->parse(argc, argv);
+    const std::size_t size_mb = cl->get<unsigned long>("size-mb");
+    const bool keep = cl->get<bool>("keep");
+    const std::size_t lines = cl->get<unsigned long>("lines");
+    const std::size_t options = cl->get<unsigned long>("options");
+    std::vector<std::string_view> benchmarks(cl->args().begin(), cl->args().end());
+    if (benchmarks.empty())
+        benchmarks = {"response-file", "response-file-0", "response-file-stream", "batch", "shell-line", "reject", "convert", "list", "lazy", "construct", "hot-paths", "complete", "subcommands"};
+    for (auto benchmark: benchmarks) {
+        if (benchmark == "response-file")
+            bench_response_file(size_mb, ResponseFiles::quoted, false, keep);
+        else if (benchmark == "response-file-0")
+            bench_response_file(size_mb, ResponseFiles::null_separated, false, keep);
+        else if (benchmark == "response-file-stream")
+            bench_response_file(size_mb, ResponseFiles::quoted, true, keep);
+        else if (benchmark == "batch")
+            bench_batch(lines);
+        else if (benchmark == "shell-line")
+            bench_shell_line(lines);
+        else if (benchmark == "reject")
+            bench_reject(lines);
+        else if (benchmark == "convert")
+            bench_convert(lines);
+        else if (benchmark == "list")
+            bench_list();
+        else if (benchmark == "lazy")
+            bench_lazy(lines);
+        else if (benchmark == "construct")
+            bench_construct(lines);
+        else if (benchmark == "hot-paths")
+            bench_hot_paths(lines);
+        else if (benchmark == "complete")
+            bench_complete(lines);
+        else if (benchmark == "subcommands")
+            bench_subcommands(lines);
+        else if (benchmark == "generate-spec")
+            generate_spec(options);
+        else
+            throw std::runtime_error("unknown benchmark " + std::string(benchmark));
+    }
+    return 0;
+}
+
+// ----------------------------------------------------------------------
+
+  // Parses a generated response file of aSizeMb megabytes, paths with an
+  // option every 1000 tokens, in quoted mode 2% of the paths are quoted or
+  // escaped. If aStream, positional arguments are passed to a callback
+  // instead of being stored.
+void bench_response_file(std::size_t aSizeMb, command_line_arguments::ResponseFiles aMode, bool aStream, bool aKeep)
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+
+    std::size_t tokens = 0, bytes = 0;
+    const std::string filename = generate_response_file(aSizeMb, aMode == command_line_arguments::ResponseFiles::null_separated, tokens, bytes);
+    const long rss_before = current_rss_kb();
+
+    auto cl = make_command_line_arguments(
+        Arg<std::string_view>('o', "output", "-", Help()),
+        Arg<Count>('v', "verbose", Count(), Help())
+                                          );
+    cl->response_files(aMode);
+    const std::string file_arg = "@" + filename;
+    const char* argv[] = {"bench", file_arg.c_str()};
+    std::size_t args = 0;
+    const auto start = std::chrono::steady_clock::now();
+    if (aStream) {
+        cl->parse(2, argv, [&args](std::string_view) { ++args; });
+    }
+    else {
+        cl->parse(2, argv);
+        args = cl->args().size();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const long rss_after = current_rss_kb(); // cl still holds the parsed arguments
+
+    if (!aKeep)
+        std::remove(filename.c_str());
+    std::printf("benchmark=response-file%s mode=%s bytes=%zu tokens=%zu args=%zu seconds=%.3f mb_per_s=%.1f ns_per_token=%.2f rss_before_kb=%ld rss_after_kb=%ld rss_delta_kb=%ld\n",
+                aStream ? "-stream" : "", aMode == command_line_arguments::ResponseFiles::null_separated ? "null_separated" : "quoted",
+                bytes, tokens, args, elapsed.count(), static_cast<double>(bytes) / 1024.0 / 1024.0 / elapsed.count(),
+                elapsed.count() * 1e9 / static_cast<double>(tokens), rss_before, rss_after, rss_after - rss_before);
+}
+
+// ----------------------------------------------------------------------
+
+  // Parses aLines generated command lines with parse_batch() using 1, 2,
+  // 4 ... threads and finally the number of cores.
+void bench_batch(std::size_t aLines)
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+
+    const auto spec = command_line_arguments::make_specification(
+        Arg<std::string_view>('o', "output", "-", Help()),
+        Arg<Count>('v', "verbose", Count(), Help()),
+        Arg<int>('j', "jobs", 1, Help()),
+        Arg<double>("threshold", 0.5, Help()),
+        Arg<bool>('n', "dry-run", false, Help())
+                                                                 );
+    std::vector<std::string> lines(aLines);
+    std::size_t bytes = 0;
+    for (std::size_t line_no = 0; line_no < aLines; ++line_no) {
+        char line[256];
+        const int length = std::snprintf(line, sizeof(line), "tool -vv -j %zu --threshold=0.%03zu %s-o /out/run-%04zu.txt /data/sample-%09zu.fastq.gz '/data/with space/%zu'",
+                                         line_no % 64, line_no % 1000, (line_no % 7) == 0 ? "-n " : "", line_no / 1000, line_no, line_no);
+        lines[line_no].assign(line, static_cast<std::size_t>(length));
+        bytes += lines[line_no].size();
+    }
+
+    const std::size_t cores = std::max(1U, std::thread::hardware_concurrency());
+    double single_thread = 0;
+    for (std::size_t threads = 1; threads <= cores; threads = (threads < cores && threads * 2 > cores) ? cores : threads * 2) {
+        const long rss_before = current_rss_kb();
+        const auto start = std::chrono::steady_clock::now();
+        const auto result = command_line_arguments::parse_batch(spec, lines, threads);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        const long rss_delta = current_rss_kb() - rss_before;
+        if (threads == 1)
+            single_thread = elapsed.count();
+        std::printf("benchmark=batch threads=%zu cores=%zu lines=%zu bytes=%zu args=%zu errors=%zu seconds=%.3f lines_per_s=%.0f ns_per_line=%.1f speedup=%.2f rss_delta_kb=%ld\n",
+                    threads, cores, aLines, bytes, result.all_args().size(), result.errors().size(), elapsed.count(),
+                    static_cast<double>(aLines) / elapsed.count(), elapsed.count() * 1e9 / static_cast<double>(aLines),
+                    single_thread / elapsed.count(), rss_delta);
+    }
+}
+
+// ----------------------------------------------------------------------
+
+  // Splits aLines generated command line strings into tokens and parses
+  // them with parse(std::string_view).
+void bench_shell_line(std::size_t aLines)
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+
+    const auto spec = command_line_arguments::make_specification(
+        Arg<std::string_view>('o', "output", "-", Help()),
+        Arg<Count>('v', "verbose", Count(), Help()),
+        Arg<int>('j', "jobs", 1, Help())
+                                                                 );
+    std::vector<std::string> lines(aLines);
+    std::size_t bytes = 0;
+    for (std::size_t line_no = 0; line_no < aLines; ++line_no) {
+        char line[512];
+        const int length = std::snprintf(line, sizeof(line), "/usr/local/bin/pipeline-tool -v --jobs %zu --output /scratch/results/run-%04zu/output.tsv /data/project/samples/sample-%09zu.fastq.gz /data/project/samples/sample-%09zu.fastq.gz '/data/project/with space/%zu.txt' \"label: run \\\"%zu\\\"\"",
+                                         line_no % 64, line_no / 1000, line_no, line_no + 1, line_no, line_no);
+        lines[line_no].assign(line, static_cast<std::size_t>(length));
+        bytes += lines[line_no].size();
+    }
+#if defined(COMMAND_LINE_ARGUMENTS_AVX2)
+    const char* const simd = "avx2";
+#elif defined(COMMAND_LINE_ARGUMENTS_SSE2)
+    const char* const simd = "sse2";
+#else
+    const char* const simd = "scalar";
+#endif
+
+    std::size_t tokens = 0;
+    std::deque<std::string> unquoted;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& line: lines) {
+        command_line_arguments::ResponseFileTokenizer tokenizer(line, command_line_arguments::ResponseFiles::quoted, unquoted);
+        for (std::string_view token; tokenizer.next(token); )
+            ++tokens;
+        unquoted.clear();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("benchmark=shell-line-tokenize simd=%s lines=%zu bytes=%zu tokens=%zu seconds=%.3f mb_per_s=%.1f ns_per_token=%.2f\n",
+                simd, aLines, bytes, tokens, elapsed.count(), static_cast<double>(bytes) / 1024.0 / 1024.0 / elapsed.count(), elapsed.count() * 1e9 / static_cast<double>(tokens));
+
+    auto result = spec.make_result();
+    std::size_t args = 0;
+    start = std::chrono::steady_clock::now();
+    for (const auto& line: lines) {
+        spec.parse(line, result);
+        args += result.args().size();
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("benchmark=shell-line-parse simd=%s lines=%zu bytes=%zu tokens=%zu args=%zu seconds=%.3f mb_per_s=%.1f ns_per_line=%.1f\n",
+                simd, aLines, bytes, tokens, args, elapsed.count(), static_cast<double>(bytes) / 1024.0 / 1024.0 / elapsed.count(), elapsed.count() * 1e9 / static_cast<double>(aLines));
+}
+
+// ----------------------------------------------------------------------
+
+  // Rejects aLines malformed command lines using parse() catching
+  // CommandLineError and using try_parse().
+void bench_reject(std::size_t aLines)
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+
+    const auto spec = command_line_arguments::make_specification(
+        Arg<std::string_view>('o', "output", "-", Help()),
+        Arg<Count>('v', "verbose", Count(), Help()),
+        Arg<int>('j', "jobs", 1, Help())
+                                                                 );
+    const char* invalid_value[] = {"tool", "-v", "--output", "out.txt", "--jobs", "many", "input.txt"};
+    const char* unknown_option[] = {"tool", "-v", "--output", "out.txt", "--job", "4", "input.txt"};
+    auto result = spec.make_result();
+    std::size_t rejected = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t line_no = 0; line_no < aLines; ++line_no) {
+        try {
+            spec.parse(7, (line_no % 2) ? invalid_value : unknown_option, result);
+        }
+        catch (command_line_arguments::CommandLineError&) {
+            ++rejected;
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("benchmark=reject-throw lines=%zu rejected=%zu seconds=%.3f ns_per_line=%.1f\n", aLines, rejected, elapsed.count(), elapsed.count() * 1e9 / static_cast<double>(aLines));
+
+    rejected = 0;
+    start = std::chrono::steady_clock::now();
+    for (std::size_t line_no = 0; line_no < aLines; ++line_no) {
+        if (!spec.try_parse(7, (line_no % 2) ? invalid_value : unknown_option, result))
+            ++rejected;
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("benchmark=reject-try-parse lines=%zu rejected=%zu seconds=%.3f ns_per_line=%.1f\n", aLines, rejected, elapsed.count(), elapsed.count() * 1e9 / static_cast<double>(aLines));
+}
+
+// ----------------------------------------------------------------------
+
+  // conversion used by Arg<T>::assign before from_chars: strto* via
+  // std::bind with the type name built for every call
+template <typename R, typename FF, typename S> inline void legacy_extract_from_string(std::string_view aValue, FF F, S type, R& aResult)
+{
+    char buffer[64];
+    std::string long_value;
+    const char* value = buffer;
+    if (aValue.size() < sizeof(buffer)) {
+        std::memcpy(buffer, aValue.data(), aValue.size());
+        buffer[aValue.size()] = 0;
+    }
+    else {
+        long_value.assign(aValue);
+        value = long_value.c_str();
+    }
+    char* end;
+    const R result = static_cast<R>(F(value, &end));
+    if (end == value || *end != 0)
+        throw command_line_arguments::CommandLineError("Cannot parse \"" + std::string(aValue) + "\" as " + type);
+    aResult = result;
+}
+
+template <typename T, typename Legacy> void bench_convert_type(const char* aType, const std::vector<std::string>& aValues, Legacy aLegacy)
+{
+    T sum{};
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& value: aValues) {
+        T converted{};
+        aLegacy(value, converted);
+        sum += converted;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double legacy_ns = elapsed.count() * 1e9 / static_cast<double>(aValues.size());
+
+    T sum_new{};
+    start = std::chrono::steady_clock::now();
+    for (const auto& value: aValues) {
+        T converted{};
+        if (command_line_arguments::_from_chars(value, converted) != command_line_arguments::ParseErrorCode::none)
+            throw std::runtime_error("cannot convert " + value);
+        sum_new += converted;
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    const double from_chars_ns = elapsed.count() * 1e9 / static_cast<double>(aValues.size());
+    std::printf("benchmark=convert type=%s values=%zu legacy_ns=%.2f from_chars_ns=%.2f speedup=%.2f checksum_equal=%d\n",
+                aType, aValues.size(), legacy_ns, from_chars_ns, legacy_ns / from_chars_ns, sum == sum_new ? 1 : 0);
+}
+
+  // Converts aLines option values of each numeric type with the old
+  // strto* path and with _from_chars().
+void bench_convert(std::size_t aLines)
+{
+    using namespace std::placeholders;
+    std::vector<std::string> ints(aLines), longs(aLines), doubles(aLines);
+    for (std::size_t no = 0; no < aLines; ++no) {
+        ints[no] = std::to_string(static_cast<int>(no * 7919 % 2000000) - 1000000);
+        longs[no] = std::to_string(no * 2654435761UL);
+        char value[64];
+        std::snprintf(value, sizeof(value), "%.6g", static_cast<double>(no) * 0.37 - 1000.0);
+        doubles[no] = value;
+    }
+    command_line_arguments::Arg<int> int_arg('i', 0, command_line_arguments::Help());
+    command_line_arguments::Arg<unsigned long> ulong_arg('u', 0UL, command_line_arguments::Help());
+    command_line_arguments::Arg<double> double_arg('d', 0.0, command_line_arguments::Help());
+    bench_convert_type<int>("int", ints, [&int_arg](std::string_view value, int& result) { legacy_extract_from_string(value, std::bind(std::strtol, _1, _2, 0), int_arg.arg_type_s(), result); });
+    bench_convert_type<unsigned long>("unsigned long", longs, [&ulong_arg](std::string_view value, unsigned long& result) { legacy_extract_from_string(value, std::bind(std::strtoul, _1, _2, 0), ulong_arg.arg_type_s(), result); });
+    bench_convert_type<double>("double", doubles, [&double_arg](std::string_view value, double& result) { legacy_extract_from_string(value, std::strtod, double_arg.arg_type_s(), result); });
+}
+
+// ----------------------------------------------------------------------
+
+  // Parses --ids=<list> of 10^3 .. 10^6 comma separated values with
+  // Arg<std::vector<T>> and with Arg<std::string> split by
+  // std::getline and converted by std::stol/std::stod.
+template <typename T> void bench_list_type(const char* aType, std::size_t aElements)
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+
+    std::string list = "--ids=";
+    for (std::size_t no = 0; no < aElements; ++no) {
+        if constexpr (std::is_floating_point<T>::value)
+            list.append(std::to_string(static_cast<double>(no) * 0.25));
+        else
+            list.append(std::to_string(no * 7919));
+        list.push_back(',');
+    }
+    list.pop_back();
+    const std::size_t repeat = std::max(std::size_t(1), std::size_t(10000000) / aElements);
+
+    const auto spec = command_line_arguments::make_specification(Arg<std::vector<T>>("ids", {}, Help()));
+    auto result = spec.make_result();
+    std::size_t elements = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t iteration = 0; iteration < repeat; ++iteration) {
+        const char* argv[] = {"bench", list.c_str()};
+        spec.parse(2, argv, result);
+        elements += result.template get<std::vector<T>>("ids").size();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double list_ns = elapsed.count() * 1e9 / static_cast<double>(elements);
+
+    const auto string_spec = command_line_arguments::make_specification(Arg<std::string>("ids", std::string(), Help()));
+    auto string_result = string_spec.make_result();
+    std::size_t string_elements = 0;
+    start = std::chrono::steady_clock::now();
+    for (std::size_t iteration = 0; iteration < repeat; ++iteration) {
+        const char* argv[] = {"bench", list.c_str()};
+        string_spec.parse(2, argv, string_result);
+        std::vector<T> values;
+        std::istringstream input(string_result.template get<std::string>("ids"));
+        for (std::string element; std::getline(input, element, ','); ) {
+            if constexpr (std::is_floating_point<T>::value)
+                values.push_back(static_cast<T>(std::stod(element)));
+            else
+                values.push_back(static_cast<T>(std::stol(element)));
+        }
+        string_elements += values.size();
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    const double split_ns = elapsed.count() * 1e9 / static_cast<double>(string_elements);
+    std::printf("benchmark=list type=%s elements=%zu bytes=%zu repeat=%zu vector_arg_ns_per_element=%.2f string_split_ns_per_element=%.2f speedup=%.2f\n",
+                aType, aElements, list.size(), repeat, list_ns, split_ns, split_ns / list_ns);
+}
+
+void bench_list()
+{
+    for (std::size_t elements = 1000; elements <= 1000000; elements *= 10)
+        bench_list_type<long>("long", elements);
+    for (std::size_t elements = 1000; elements <= 1000000; elements *= 10)
+        bench_list_type<double>("double", elements);
+}
+
+// ----------------------------------------------------------------------
+
+  // Wrapper tool: 16 options each given 3 times, only 2 of them are read.
+  // Eager and lazy conversion are compared.
+void bench_lazy(std::size_t aLines)
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+
+    auto spec = command_line_arguments::make_specification(
+        Arg<std::string>("s0", std::string(), Help()), Arg<std::string>("s1", std::string(), Help()), Arg<std::string>("s2", std::string(), Help()), Arg<std::string>("s3", std::string(), Help()),
+        Arg<double>("d0", 0.0, Help()), Arg<double>("d1", 0.0, Help()), Arg<double>("d2", 0.0, Help()), Arg<double>("d3", 0.0, Help()),
+        Arg<long>("l0", 0L, Help()), Arg<long>("l1", 0L, Help()), Arg<long>("l2", 0L, Help()), Arg<long>("l3", 0L, Help()),
+        Arg<int>("i0", 0, Help()), Arg<int>("i1", 0, Help()), Arg<int>("i2", 0, Help()), Arg<int>("i3", 0, Help())
+                                                           );
+    const auto handles = spec.handles();
+    std::vector<std::string> tokens{"wrapper"};
+    for (int repeat = 0; repeat < 3; ++repeat) {
+        for (const char* prefix: {"s", "d", "l", "i"}) {
+            for (int no = 0; no < 4; ++no) {
+                tokens.push_back("--" + std::string(prefix) + std::to_string(no));
+                tokens.push_back(prefix[0] == 's' ? "/some/long/path/that/does/not/fit/into/small/string/buffer-" + std::to_string(no) : std::to_string(1234 + no + repeat) + (prefix[0] == 'd' ? ".125" : ""));
+            }
+        }
+    }
+    std::vector<const char*> argv;
+    for (const auto& token: tokens)
+        argv.push_back(token.c_str());
+
+    for (auto conversion: {command_line_arguments::Conversion::eager, command_line_arguments::Conversion::lazy}) {
+        spec.conversion(conversion);
+        auto result = spec.make_result();
+        double sum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t line_no = 0; line_no < aLines; ++line_no) {
+            spec.parse(static_cast<int>(argv.size()), argv.data(), result);
+            sum += result.get(handles.get<4>()) + static_cast<double>(result.get(handles.get<8>()));
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::printf("benchmark=lazy conversion=%s lines=%zu tokens=%zu seconds=%.3f ns_per_line=%.1f checksum=%.0f\n",
+                    conversion == command_line_arguments::Conversion::lazy ? "lazy" : "eager", aLines, argv.size(), elapsed.count(), elapsed.count() * 1e9 / static_cast<double>(aLines), sum);
+    }
+}
+
+// ----------------------------------------------------------------------
+
+  // the same 16 options for the runtime and compile time built parsers
+#define BENCH_CONSTRUCT_OPTIONS \
+    Arg<std::string_view>('o', "output", "-", Help("output file")), Arg<std::string_view>('i', "input", "-", Help("input file")), \
+    Arg<std::string_view>("log", "", Help("log file")), Arg<std::string_view>("format", "json", Help("output format")), \
+    Arg<int>('j', "jobs", 1, Help("number of jobs")), Arg<int>("retries", 3, Help("number of retries")), \
+    Arg<long>("seed", 0L, Help("random seed")), Arg<unsigned long>("limit", 1000UL, Help("max number of records")), \
+    Arg<double>("threshold", 0.5, Help("threshold")), Arg<double>("ratio", 1.0, Help("ratio")), \
+    Arg<bool>('n', "dry-run", false, Help("do nothing")), Arg<bool>('f', "force", false, Help("overwrite output")), \
+    Arg<bool>("color", false, Help("colored output")), Arg<Count>('v', "verbose", Count(), Help("more messages")), \
+    Arg<Count>('q', "quiet", Count(), Help("less messages")), Arg<PrintHelp>('h', "help", "Usage: {progname} [options] <file>", Help("prints this help text"))
+
+  // Startup cost of the parser: make_command_line_arguments() (tuple
+  // copied to the heap, tables built at run time) against make_result()
+  // of a constexpr specification, each followed by parsing a short
+  // command line.
+void bench_construct(std::size_t aLines)
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+    using command_line_arguments::PrintHelp;
+
+    static constexpr auto spec = command_line_arguments::make_specification(BENCH_CONSTRUCT_OPTIONS);
+    const char* argv[] = {"tool", "-vj", "4", "--output=out.txt", "input.txt"};
+
+    int sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t line_no = 0; line_no < aLines; ++line_no) {
+        auto cl = make_command_line_arguments(BENCH_CONSTRUCT_OPTIONS);
+        cl->parse(5, argv);
+        sum += cl->get<int>('j');
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("benchmark=construct parser=runtime options=16 lines=%zu seconds=%.3f ns_per_line=%.1f checksum=%d\n", aLines, elapsed.count(), elapsed.count() * 1e9 / static_cast<double>(aLines), sum);
+
+    sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (std::size_t line_no = 0; line_no < aLines; ++line_no) {
+        auto result = spec.make_result();
+        spec.parse(5, argv, result);
+        sum += result.get<int>('j');
+    }
+    elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("benchmark=construct parser=constexpr options=16 lines=%zu seconds=%.3f ns_per_line=%.1f checksum=%d\n", aLines, elapsed.count(), elapsed.count() * 1e9 / static_cast<double>(aLines), sum);
+}
+
+// ----------------------------------------------------------------------
+
+  // 32 subcommands "cmd00", "cmd01", ... with the 16 options above each
+struct BenchCommandNames
+{
+    constexpr BenchCommandNames() : names{}
+        {
+            for (std::size_t no = 0; no < std::size(names); ++no) {
+                names[no][0] = 'c';
+                names[no][1] = 'm';
+                names[no][2] = 'd';
+                names[no][3] = static_cast<char>('0' + no / 10);
+                names[no][4] = static_cast<char>('0' + no % 10);
+            }
+        }
+    char names[32][6];
+};
+
+static constexpr BenchCommandNames sBenchCommandNames;
+
+inline auto bench_command_specification()
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+    using command_line_arguments::PrintHelp;
+    return command_line_arguments::make_specification(BENCH_CONSTRUCT_OPTIONS);
+}
+
+template <std::size_t ... Inds> constexpr auto bench_subcommands(std::index_sequence<Inds...>)
+{
+    using command_line_arguments::Subcommand;
+    using command_line_arguments::Help;
+    return command_line_arguments::make_subcommands(Subcommand(std::string_view(sBenchCommandNames.names[Inds]), Help("subcommand"), &bench_command_specification) ...);
+}
+
+  // Startup of a multi-tool binary: all 32 subcommand parsers made by
+  // make_command_line_arguments() before the one named by argv[1] is
+  // used, against global options (constexpr) followed by dispatch to
+  // the subcommand whose specification alone is made.
+void bench_subcommands(std::size_t aLines)
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+    using command_line_arguments::PrintHelp;
+    using cl_t = decltype(make_command_line_arguments(BENCH_CONSTRUCT_OPTIONS));
+
+    constexpr std::size_t commands_size = std::size(sBenchCommandNames.names);
+    static constexpr auto commands = bench_subcommands(std::make_index_sequence<commands_size>{});
+    static constexpr auto global = command_line_arguments::make_specification(Arg<Count>("debug", Count(), Help("debug messages")));
+    const char* argv[] = {"tool", "--debug", "cmd17", "-vj", "4", "--output=out.txt", "input.txt"};
+    using clock = std::chrono::steady_clock;
+    using ns = std::chrono::duration<double, std::nano>;
+
+    int sum = 0;
+    std::size_t allocations = sAllocations;
+    auto start = clock::now();
+    for (std::size_t line_no = 0; line_no < aLines; ++line_no) {
+        cl_t parsers[commands_size];
+        for (std::size_t no = 0; no < commands_size; ++no)
+            parsers[no] = make_command_line_arguments(BENCH_CONSTRUCT_OPTIONS);
+        auto& cl = parsers[commands.find(argv[2])];
+        cl->parse(5, argv + 2);
+        sum += cl->get<int>('j');
+    }
+    ns elapsed = clock::now() - start;
+    std::printf("benchmark=subcommands mode=eager commands=%zu options=16 lines=%zu ns_per_line=%.1f allocations_per_line=%.1f parser_bytes=%zu checksum=%d\n", commands_size, aLines,
+                elapsed.count() / static_cast<double>(aLines), static_cast<double>(sAllocations - allocations) / static_cast<double>(aLines), commands_size * sizeof(*std::declval<cl_t>()), sum);
+
+    sum = 0;
+    allocations = sAllocations;
+    start = clock::now();
+    for (std::size_t line_no = 0; line_no < aLines; ++line_no) {
+        auto result = global.make_result();
+        global.parse(7, argv, result, commands, [&sum](std::string_view, const auto& aResult) { sum += aResult.template get<int>('j'); });
+    }
+    elapsed = clock::now() - start;
+    std::printf("benchmark=subcommands mode=lazy commands=%zu options=16 lines=%zu ns_per_line=%.1f allocations_per_line=%.1f parser_bytes=%zu checksum=%d\n", commands_size, aLines,
+                elapsed.count() / static_cast<double>(aLines), static_cast<double>(sAllocations - allocations) / static_cast<double>(aLines), sizeof(bench_command_specification()) + sizeof(bench_command_specification().make_result()), sum);
+}
+
+#undef BENCH_CONSTRUCT_OPTIONS
+
+// ----------------------------------------------------------------------
+
+  // Synthetic specifications for the hot-paths benchmark: options
+  // "o000", "o001", ... of types cycling through bench_option_t, the
+  // first ones also have short names.
+struct BenchOptionNames
+{
+    constexpr BenchOptionNames() : names{}
+        {
+            for (std::size_t no = 0; no < std::size(names); ++no) {
+                names[no][0] = 'o';
+                names[no][1] = static_cast<char>('0' + no / 100);
+                names[no][2] = static_cast<char>('0' + no / 10 % 10);
+                names[no][3] = static_cast<char>('0' + no % 10);
+            }
+        }
+    char names[1000][5];
+};
+
+static constexpr BenchOptionNames sBenchOptionNames;
+static constexpr std::string_view sBenchShortNames = "abcdefgijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+enum class BenchKind { boolean, count, integer, real, view, string };
+constexpr std::size_t sBenchKinds = 6;
+constexpr BenchKind bench_kind(std::size_t aIndex) { return static_cast<BenchKind>(aIndex % sBenchKinds); }
+
+template <std::size_t Ind> using bench_option_t =
+        std::tuple_element_t<Ind % sBenchKinds, std::tuple<bool, command_line_arguments::Count, int, double, std::string_view, std::string>>;
+
+template <std::size_t Ind> inline auto bench_option()
+{
+    using command_line_arguments::Arg;
+    using command_line_arguments::Help;
+    using T = bench_option_t<Ind>;
+    const char short_name = Ind < sBenchShortNames.size() ? sBenchShortNames[Ind] : 0;
+    return Arg<T>(short_name, std::string_view(sBenchOptionNames.names[Ind]), T{}, Help("help text of a synthetic option"));
+}
+
+template <std::size_t... Inds> inline auto bench_specification(std::index_sequence<Inds...>)
+{
+    return command_line_arguments::make_specification(bench_option<Inds>()...);
+}
+
+inline double bench_value(bool aValue) { return aValue ? 1.0 : 0.0; }
+inline double bench_value(command_line_arguments::Count aValue) { return static_cast<double>(static_cast<std::size_t>(aValue)); }
+inline double bench_value(int aValue) { return aValue; }
+inline double bench_value(double aValue) { return aValue; }
+inline double bench_value(std::string_view aValue) { return static_cast<double>(aValue.size()); }
+
+template <typename Result, std::size_t... Inds> inline double bench_get_by_name(const Result& aResult, std::index_sequence<Inds...>)
+{
+    return (bench_value(aResult.template get<bench_option_t<Inds>>(std::string_view(sBenchOptionNames.names[Inds]))) + ...);
+}
+
+template <typename Result, typename Handles, std::size_t... Inds> inline double bench_get_by_handle(const Result& aResult, const Handles& aHandles, std::index_sequence<Inds...>)
+{
+    return (bench_value(aResult.get(aHandles.template get<Inds>())) + ...);
+}
+
+  // Command line of the given shape for the first aOptions synthetic options:
+  //   separate:    --o002 12345 --o003 0.125 ...
+  //   equals:      --o002=12345 --o003=0.125 ...
+  //   bundled:     -abgjmp... (bool and Count short switches) 16 times
+  //   positionals: 1000 paths and 2 options
+  //   numeric:     int and double options only, each given 4 times
+std::vector<std::string> bench_hot_paths_tokens(std::size_t aOptions, std::string_view aInput)
+{
+    const auto value = [](std::size_t aIndex) -> std::string {
+        switch (bench_kind(aIndex)) {
+          case BenchKind::integer: return std::to_string(12345 + aIndex);
+          case BenchKind::real: return "0.125";
+          case BenchKind::view: return "/data/project/sample.fastq.gz";
+          case BenchKind::string: return "text-" + std::to_string(aIndex);
+          default: return std::string();
+        }
+    };
+    const auto is_switch = [](std::size_t aIndex) { return bench_kind(aIndex) == BenchKind::boolean || bench_kind(aIndex) == BenchKind::count; };
+
+    std::vector<std::string> tokens{"tool"};
+    if (aInput == "bundled") {
+        std::string flags{"-"};
+        for (std::size_t no = 0; no < std::min(aOptions, sBenchShortNames.size()); ++no) {
+            if (is_switch(no))
+                flags.push_back(sBenchShortNames[no]);
+        }
+        tokens.insert(tokens.end(), 16, flags);
+    }
+    else if (aInput == "positionals") {
+        tokens.insert(tokens.end(), {"--o001", "--o002", value(2)});
+        for (std::size_t no = 0; no < 1000; ++no)
+            tokens.push_back("/data/project/run-" + std::to_string(no / 100) + "/sample-" + std::to_string(no) + ".fastq.gz");
+    }
+    else {
+        const bool numeric = aInput == "numeric";
+        for (std::size_t repeat = 0; repeat < (numeric ? 4 : 1); ++repeat) {
+            for (std::size_t no = 0; no < aOptions; ++no) {
+                if (numeric && bench_kind(no) != BenchKind::integer && bench_kind(no) != BenchKind::real)
+                    continue;
+                const std::string name = "--" + std::string(sBenchOptionNames.names[no]);
+                if (is_switch(no))
+                    tokens.push_back(name);
+                else if (aInput == "equals")
+                    tokens.push_back(name + "=" + value(no));
+                else
+                    tokens.insert(tokens.end(), {name, value(no)});
+            }
+        }
+    }
+    return tokens;
+}
+
+  // Parses each command line shape with a specification of Options
+  // synthetic options, then reads all values by name and by handle,
+  // reports them and prints help. Prints one line per shape: time per
+  // token or call, allocations per parse or call, growth of the resident
+  // set from making the result to the last help call.
+template <std::size_t Options> void bench_hot_paths_spec(std::size_t aLines)
+{
+    static const auto spec = bench_specification(std::make_index_sequence<Options>{});
+    const auto handles = spec.handles();
+    using clock = std::chrono::steady_clock;
+    using ns = std::chrono::duration<double, std::nano>;
+
+    for (std::string_view input: {"separate", "equals", "bundled", "positionals", "numeric"}) {
+        const auto tokens = bench_hot_paths_tokens(Options, input);
+        std::vector<const char*> argv;
+        for (const auto& token: tokens)
+            argv.push_back(token.c_str());
+        const std::size_t parses = std::max<std::size_t>(aLines * 4 / argv.size(), 10);
+        double sum = 0;
+
+        const long rss_before = current_rss_kb();
+        auto result = spec.make_result();
+        spec.parse(static_cast<int>(argv.size()), argv.data(), result); // warm up: positionals storage
+        std::size_t allocations = sAllocations;
+        auto start = clock::now();
+        for (std::size_t parse_no = 0; parse_no < parses; ++parse_no) // argv is permuted by the first parse, the next ones find it as is
+            spec.parse(static_cast<int>(argv.size()), argv.data(), result);
+        const ns parse_time = clock::now() - start;
+        const std::size_t parse_allocations = sAllocations - allocations;
+
+        const std::size_t gets = std::max<std::size_t>(parses / 10, 1);
+        start = clock::now();
+        for (std::size_t get_no = 0; get_no < gets; ++get_no)
+            sum += bench_get_by_name(result, std::make_index_sequence<Options>{});
+        const ns get_name_time = clock::now() - start;
+        start = clock::now();
+        for (std::size_t get_no = 0; get_no < gets; ++get_no)
+            sum += bench_get_by_handle(result, handles, std::make_index_sequence<Options>{});
+        const ns get_handle_time = clock::now() - start;
+
+        const std::size_t calls = std::max<std::size_t>(parses / 100, 10);
+        std::ostringstream report, help;
+        result.report(report);
+        spec.print_help(help, "tool");
+        allocations = sAllocations;
+        start = clock::now();
+        for (std::size_t call_no = 0; call_no < calls; ++call_no) {
+            report.seekp(0);
+            result.report(report);
+        }
+        const ns report_time = clock::now() - start;
+        const std::size_t report_allocations = sAllocations - allocations;
+        allocations = sAllocations;
+        start = clock::now();
+        for (std::size_t call_no = 0; call_no < calls; ++call_no) {
+            help.seekp(0);
+            spec.print_help(help, "tool");
+        }
+        const ns help_time = clock::now() - start;
+        const std::size_t help_allocations = sAllocations - allocations;
+        const long rss_delta = current_rss_kb() - rss_before;
+
+        const double total_gets = static_cast<double>(gets * Options);
+        std::printf("benchmark=hot-paths options=%zu input=%s tokens=%zu parses=%zu parse_ns_per_token=%.2f parse_ns=%.0f allocations_per_parse=%.2f"
+                    " get_name_ns=%.2f get_handle_ns=%.2f report_ns=%.0f report_bytes=%zu allocations_per_report=%.2f help_ns=%.0f help_bytes=%zu allocations_per_help=%.2f rss_delta_kb=%ld checksum=%.0f\n",
+                    Options, input.data(), argv.size(), parses,
+                    parse_time.count() / static_cast<double>(parses * argv.size()), parse_time.count() / static_cast<double>(parses), static_cast<double>(parse_allocations) / static_cast<double>(parses),
+                    get_name_time.count() / total_gets, get_handle_time.count() / total_gets,
+                    report_time.count() / static_cast<double>(calls), static_cast<std::size_t>(report.tellp()), static_cast<double>(report_allocations) / static_cast<double>(calls),
+                    help_time.count() / static_cast<double>(calls), static_cast<std::size_t>(help.tellp()), static_cast<double>(help_allocations) / static_cast<double>(calls),
+                    rss_delta, sum + static_cast<double>(result.args().size()));
+    }
+}
+
+void bench_hot_paths(std::size_t aLines)
+{
+    bench_hot_paths_spec<8>(aLines);
+    bench_hot_paths_spec<64>(aLines);
+    bench_hot_paths_spec<256>(aLines);
+}
+
+// ----------------------------------------------------------------------
+
+  // 1000 long names "<word>-<word>" of a tool with many options for the
+  // completion benchmark
+struct BenchCompletionNames
+{
+    static constexpr const char* words[] = {
+        "alpha", "beta", "cache", "color", "debug", "depth", "dry", "exec", "file", "force", "git", "hash", "index", "jobs", "keep", "log",
+        "max", "min", "no", "output", "path", "quiet", "retry", "size", "temp", "trace", "user", "verbose", "warn", "xml", "yaml", "zone"};
+
+    constexpr BenchCompletionNames() : names{}
+        {
+            for (std::size_t no = 0; no < std::size(names); ++no) {
+                std::size_t pos = 0;
+                for (const char* c = words[no / std::size(words)]; *c != 0; ++c)
+                    names[no][pos++] = *c;
+                names[no][pos++] = '-';
+                for (const char* c = words[no % std::size(words)]; *c != 0; ++c)
+                    names[no][pos++] = *c;
+            }
+        }
+    char names[1000][16];
+};
+
+static constexpr BenchCompletionNames sBenchCompletionNames;
+
+template <std::size_t... Inds> constexpr auto bench_completion_specification(std::index_sequence<Inds...>)
+{
+    return command_line_arguments::make_specification(command_line_arguments::Arg<bool>(std::string_view(sBenchCompletionNames.names[Inds]), false, command_line_arguments::Help())...);
+}
+
+  // Completion queries and abbreviated options against a compile time
+  // specification of 1000 long options: time per complete(prefix) call
+  // (binary search in the sorted name table plus a callback per match),
+  // per query mode call writing the matches, per parse of a command line
+  // with an abbreviated and with a full option name.
+void bench_complete(std::size_t aLines)
+{
+    static constexpr auto spec = bench_completion_specification(std::make_index_sequence<std::size(sBenchCompletionNames.names)>{});
+    using clock = std::chrono::steady_clock;
+    using ns = std::chrono::duration<double, std::nano>;
+
+    for (std::string_view prefix: {"verbose-tr", "verbose-", "v", "", "zzz"}) {
+        std::size_t matches = 0, sum = 0;
+        const auto start = clock::now();
+        for (std::size_t line_no = 0; line_no < aLines; ++line_no)
+            matches += spec.complete(prefix, [&sum](std::string_view aName) { sum += aName.size(); });
+        const ns elapsed = clock::now() - start;
+        std::printf("benchmark=complete mode=lookup options=%zu prefix=\"%.*s\" matches=%zu ns_per_query=%.1f checksum=%zu\n",
+                    std::size(sBenchCompletionNames.names), static_cast<int>(prefix.size()), prefix.data(), matches / aLines, elapsed.count() / static_cast<double>(aLines), sum);
+    }
+
+    const char* query[] = {"tool", "--complete", "--verbose-t"};
+    std::ostringstream out;
+    auto start = clock::now();
+    for (std::size_t line_no = 0; line_no < aLines; ++line_no) {
+        out.seekp(0);
+        spec.complete(3, query, out);
+    }
+    ns elapsed = clock::now() - start;
+    std::printf("benchmark=complete mode=query options=%zu word=%s output_bytes=%zu ns_per_query=%.1f\n", std::size(sBenchCompletionNames.names), query[2], static_cast<std::size_t>(out.tellp()), elapsed.count() / static_cast<double>(aLines));
+
+    auto result = spec.make_result();
+    for (const char* option: {"--verbose-tr", "--verbose-trace"}) {
+        const char* argv[] = {"tool", option};
+        std::size_t errors = 0;
+        start = clock::now();
+        for (std::size_t line_no = 0; line_no < aLines; ++line_no)
+            errors += spec.try_parse(2, argv, result) ? 0 : 1;
+        elapsed = clock::now() - start;
+        std::printf("benchmark=complete mode=parse options=%zu option=%s errors=%zu ns_per_parse=%.1f\n", std::size(sBenchCompletionNames.names), option, errors, elapsed.count() / static_cast<double>(aLines));
+    }
+}
+
+// ----------------------------------------------------------------------
+
+  // Writes to stdout a program with aOptions options of mixed types
+  // that reads every tenth option by name, reports all values, prints
+  // help and measures parsing of a command line giving each option
+  // once. Compiled by make bench-scaling to measure compile time and
+  // object size.
+void generate_spec(std::size_t aOptions)
+{
+    struct type_t { const char* type; const char* default_value; const char* value; };
+    const type_t types[] = {
+        {"std::string_view", "\"-\"", "=/some/path"}, {"int", "0", "=42"}, {"double", "0.5", "=0.25"}, {"bool", "false", ""},
+        {"std::string", "std::string()", "=text"}, {"long", "0L", "=-7"}, {"Count", "Count()", ""}, {"unsigned long", "0UL", "=0x10"}};
+    const std::string short_names = "abcdefgijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+    std::printf("#include <chrono>\n#include <cstdio>\n#include \"command-line-arguments.hh\"\n\n"
+                "int main(int argc, const char* argv[])\n{\n"
+                "    using namespace command_line_arguments;\n"
+                "    const auto spec = make_specification(\n");
+    for (std::size_t no = 0; no < aOptions; ++no) {
+        const type_t& type = types[no % std::size(types)];
+        const std::string short_name = no < short_names.size() ? "'" + std::string(1, short_names[no]) + "', " : std::string();
+        std::printf("        Arg<%s>(%s\"option-%zu\", %s, Help(\"help text of option %zu\")),\n", type.type, short_name.c_str(), no, type.default_value, no);
+    }
+    std::printf("        Arg<PrintHelp>('h', \"help\", \"Usage: {progname} [options] <file>\", Help(\"prints this help text\")));\n\n"
+                "    const char* args[] = {\"tool\",\n");
+    for (std::size_t no = 0; no < aOptions; ++no)
+        std::printf("        \"--option-%zu%s\",\n", no, types[no % std::size(types)].value);
+    std::printf("        \"file\"};\n"
+                "    const std::size_t tokens = std::size(args), lines = argc > 1 ? std::stoul(argv[1]) : 10000000 / tokens + 1;\n"
+                "    auto result = spec.make_result();\n"
+                "    double sum = 0;\n"
+                "    const auto start = std::chrono::steady_clock::now();\n"
+                "    std::vector<const char*> line;\n"
+                "    for (std::size_t line_no = 0; line_no < lines; ++line_no) {\n"
+                "        line.assign(std::begin(args), std::end(args));\n"
+                "        spec.parse(static_cast<int>(line.size()), line.data(), result);\n");
+    for (std::size_t no = 0; no < aOptions; no += 10) {
+        const type_t& type = types[no % std::size(types)];
+        if (type.type == std::string_view("std::string_view") || type.type == std::string_view("std::string"))
+            std::printf("        sum += static_cast<double>(result.get<%s>(\"option-%zu\").size());\n", type.type, no);
+        else if (type.type == std::string_view("Count"))
+            std::printf("        sum += static_cast<double>(static_cast<std::size_t>(result.get<Count>(\"option-%zu\")));\n", no);
+        else
+            std::printf("        sum += static_cast<double>(result.get<%s>(\"option-%zu\"));\n", type.type, no);
+    }
+    std::printf("    }\n"
+                "    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;\n"
+                "    std::ostringstream report, help;\n"
+                "    result.report(report);\n"
+                "    spec.print_help(help, \"tool\");\n"
+                "    std::printf(\"tokens=%%zu lines=%%zu ns_per_token=%%.2f report_bytes=%%zu help_bytes=%%zu checksum=%%.0f\\n\", tokens, lines, elapsed.count() * 1e9 / static_cast<double>(tokens * lines), report.str().size(), help.str().size(), sum);\n"
+                "    return 0;\n}\n");
+}
+
+// ----------------------------------------------------------------------
+
+std::string generate_response_file(std::size_t aSizeMb, bool aNullSeparated, std::size_t& aTokens, std::size_t& aBytes)
+{
+    const std::string filename = std::string("/tmp/command-line-arguments-bench-") + (aNullSeparated ? "null" : "quoted") + ".rsp";
+    std::FILE* output = std::fopen(filename.c_str(), "wb");
+    if (output == nullptr)
+        throw std::runtime_error("cannot create " + filename);
+    const std::size_t size = aSizeMb * 1024 * 1024;
+    const char separator = aNullSeparated ? '\0' : '\n';
+    std::string chunk;
+    aTokens = 0;
+    std::size_t written = 0;
+    while (written < size) {
+        chunk.clear();
+        while (chunk.size() < 1024 * 1024) {
+            char token[128];
+            int length;
+            if ((aTokens % 1000) == 999)
+                length = std::snprintf(token, sizeof(token), "-v");
+            else if (!aNullSeparated && (aTokens % 100) == 50)
+                length = std::snprintf(token, sizeof(token), "'/data/project/run %04zu/sample %09zu.fastq.gz'", aTokens / 10000, aTokens);
+            else if (!aNullSeparated && (aTokens % 100) == 51)
+                length = std::snprintf(token, sizeof(token), "/data/project/run\\ %04zu/sample\\ %09zu.fastq.gz", aTokens / 10000, aTokens);
+            else
+                length = std::snprintf(token, sizeof(token), "/data/project/run-%04zu/sample-%09zu.fastq.gz", aTokens / 10000, aTokens);
+            chunk.append(token, static_cast<std::size_t>(length)).push_back(separator);
+            ++aTokens;
+        }
+        std::fwrite(chunk.data(), 1, chunk.size(), output);
+        written += chunk.size();
+    }
+    std::fclose(output);
+    aBytes = written;
+    return filename;
+}
+
+// ----------------------------------------------------------------------
+
+  // resident set of the process now (not the peak, which only grows and
+  // would hide what each measurement uses), 0 if /proc is not available
+long current_rss_kb()
+{
+    long size = 0, resident = 0;
+    if (FILE* statm = std::fopen("/proc/self/statm", "r"); statm != nullptr) {
+        if (std::fscanf(statm, "%ld %ld", &size, &resident) != 2)
+            resident = 0;
+        std::fclose(statm);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// ----------------------------------------------------------------------
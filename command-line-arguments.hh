@@ -1,15 +1,49 @@
 #pragma once
 
 #include <typeinfo>
-#include <functional>
 #include <algorithm>
 #include <memory>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <iterator>
 #include <cstring>
 #include <vector>
 #include <tuple>
+#include <type_traits>
+#include <cstdint>
+#include <cerrno>
+#include <charconv>
+#include <limits>
+#include <deque>
+#include <optional>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define COMMAND_LINE_ARGUMENTS_MMAP
+#else
+#include <fstream>
+#endif
+
+  // vectorized scanning of quoted command lines and response files,
+  // define COMMAND_LINE_ARGUMENTS_NO_SIMD to use the scalar code only
+#if !defined(COMMAND_LINE_ARGUMENTS_NO_SIMD) && defined(__GNUC__)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define COMMAND_LINE_ARGUMENTS_AVX2
+#define COMMAND_LINE_ARGUMENTS_SSE2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define COMMAND_LINE_ARGUMENTS_SSE2
+#endif
+#endif
 
 // ----------------------------------------------------------------------
 
@@ -25,18 +59,153 @@ namespace command_line_arguments
     };
 #pragma GCC diagnostic pop
 
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS)
+#define COMMAND_LINE_ARGUMENTS_EXCEPTIONS
+#endif
+
+      // throws aError or, if compiled with -fno-exceptions, reports it and aborts
+    [[noreturn]] inline void _raise(const CommandLineError& aError)
+    {
+#ifdef COMMAND_LINE_ARGUMENTS_EXCEPTIONS
+        throw aError;
+#else
+        std::cerr << "ERROR: " << aError.what() << std::endl;
+        std::abort();
+#endif
+    }
+
+    inline std::string _option_name_s(char aName) { return std::string("-") + aName; }
+    inline std::string _option_name_s(std::string_view aName) { return "--" + std::string(aName); }
+
+// ----------------------------------------------------------------------
+
+    enum class ParseErrorCode : unsigned char
+    {
+        none,
+        help_requested,             // Arg<PrintHelp> option found
+        unrecognized_long_option,
+        unrecognized_short_option,
+        ambiguous_long_option,      // abbreviation matches more than one long option
+        missing_value,              // option requiring a value is the last token
+        invalid_value,              // value cannot be converted to the option type
+        value_out_of_range,         // value does not fit into the option type
+        too_many_arguments,
+        too_few_arguments,
+        unterminated_quote,         // in a response file or a command line string
+        response_file_unreadable,
+        response_files_nested_too_deeply,
+        missing_subcommand,         // no positional argument after global options
+        unknown_subcommand,         // first positional argument is not a subcommand name
+        subcommand_in_response_file // first positional argument is in a response file, not in argv
+    };
+
+      // Error found by try_parse(). Nothing is allocated until message()
+      // is called, text() is a view of the parsed tokens (or of the parse
+      // result for unquoted tokens) and is valid until the next parse.
+    class ParseError
+    {
+     public:
+        static constexpr std::size_t npos = std::size_t(-1);
+
+        inline ParseError() = default;
+        inline ParseError(ParseErrorCode aCode, std::size_t aTokenNo, std::size_t aOption, std::string_view aText, const char* aDetail = nullptr, int aSystemError = 0)
+            : mCode(aCode), mSystemError(aSystemError), mTokenNo(aTokenNo), mOption(aOption), mText(aText), mDetail(aDetail) {}
+
+        inline ParseErrorCode code() const { return mCode; }
+          // position of the offending token on the original command line
+          // (before parse() permuted argv), the program name is 0, tokens of
+          // expanded response files are counted
+        inline std::size_t token_no() const { return mTokenNo; }
+          // index of the option in the specification or npos
+        inline std::size_t option() const { return mOption; }
+          // offending option, value, response file name or quoted token
+        inline std::string_view text() const { return mText; }
+          // value type for invalid_value and value_out_of_range, failed operation for response_file_unreadable
+        inline const char* detail() const { return mDetail; }
+          // errno for response_file_unreadable
+        inline int system_error() const { return mSystemError; }
+
+        inline std::string message() const
+            {
+                const std::string text(mText);
+                const std::string name = (!text.empty() && text[0] == '-') ? text : ("-" + text);
+                switch (mCode) {
+                  case ParseErrorCode::none:
+                      return std::string();
+                  case ParseErrorCode::help_requested:
+                      return "Help requested";
+                  case ParseErrorCode::unrecognized_long_option:
+                      return "Unrecognized long option " + text;
+                  case ParseErrorCode::unrecognized_short_option:
+                      return "Unrecognized short option " + name;
+                  case ParseErrorCode::ambiguous_long_option:
+                      return "Ambiguous long option " + text;
+                  case ParseErrorCode::missing_value:
+                      return "Switch " + name + " requires a parameter, but end of command line arguments reached";
+                  case ParseErrorCode::invalid_value:
+                      return "Cannot parse \"" + text + "\" as " + (mDetail != nullptr ? mDetail : "");
+                  case ParseErrorCode::value_out_of_range:
+                      return "Value \"" + text + "\" is out of range of " + (mDetail != nullptr ? mDetail : "");
+                  case ParseErrorCode::too_many_arguments:
+                      return "Too many arguments provided";
+                  case ParseErrorCode::too_few_arguments:
+                      return "Too few arguments provided";
+                  case ParseErrorCode::unterminated_quote:
+                      return "Unterminated quote: " + text;
+                  case ParseErrorCode::response_file_unreadable:
+                      return std::string("Cannot ") + (mDetail != nullptr ? mDetail : "read") + " response file " + text + (mSystemError != 0 ? std::string(": ") + std::strerror(mSystemError) : std::string());
+                  case ParseErrorCode::response_files_nested_too_deeply:
+                      return "Response files nested too deeply: " + text;
+                  case ParseErrorCode::missing_subcommand:
+                      return "Subcommand expected";
+                  case ParseErrorCode::unknown_subcommand:
+                      return "Unknown subcommand " + text;
+                  case ParseErrorCode::subcommand_in_response_file:
+                      return "Subcommand cannot be given in a response file: " + text;
+                }
+                return std::string();
+            }
+
+     private:
+        ParseErrorCode mCode = ParseErrorCode::none;
+        int mSystemError = 0;
+        std::size_t mTokenNo = 0;
+        std::size_t mOption = npos;
+        std::string_view mText;
+        const char* mDetail = nullptr;
+    };
+
+      // expected-style result of try_parse(): true on success, error() otherwise
+    class ParseStatus
+    {
+     public:
+        inline ParseStatus() = default;
+        inline ParseStatus(const ParseError& aError) : mError(aError) {}
+
+        inline bool has_value() const { return mError.code() == ParseErrorCode::none; }
+        explicit inline operator bool() const { return has_value(); }
+        inline const ParseError& error() const { return mError; }
+
+     private:
+        ParseError mError;
+    };
+
 // ----------------------------------------------------------------------
 
-      // special argument type to generate help
+      // special argument type to generate help, the usage text is not
+      // copied, it must outlive the option (e.g. a string literal), a
+      // temporary std::string does not compile
     class PrintHelp
     {
      public:
-        inline PrintHelp() : mUsage("Usage: {progname} [options]") {}
-        template <typename Text> inline PrintHelp(Text aUsage) : mUsage(aUsage) {}
+        constexpr PrintHelp() : mUsage("Usage: {progname} [options]") {}
+        template <typename Text> constexpr PrintHelp(const Text& aUsage) : mUsage(aUsage) {}
+        PrintHelp(std::string&&) = delete;
+        PrintHelp(const std::string&&) = delete;
 
-        inline std::string message(std::string progname) const
+        inline std::string message(std::string_view progname) const
             {
-                std::string msg = mUsage;
+                std::string msg(mUsage);
                 const std::string::size_type pos = msg.find("{progname}");
                 if (pos != std::string::npos)
                     msg.erase(pos, 10).insert(pos, progname);
@@ -44,7 +213,7 @@ namespace command_line_arguments
             }
 
      private:
-        std::string mUsage;
+        std::string_view mUsage;
     };
 
     inline std::ostream& operator << (std::ostream& out, const PrintHelp&) { return out; }
@@ -55,7 +224,7 @@ namespace command_line_arguments
     class Count
     {
      public:
-        inline Count() : mValue(0) {}
+        constexpr Count() : mValue(0) {}
         inline Count& operator ++ () { ++mValue; return *this; }
         inline operator int () const { return static_cast<int>(mValue); }
         inline operator std::size_t () const { return mValue; }
@@ -67,56 +236,92 @@ namespace command_line_arguments
 
 // ----------------------------------------------------------------------
 
-#pragma GCC diagnostic push
-#ifdef __clang__
-#pragma GCC diagnostic ignored "-Wweak-vtables"
-#endif
-    class ArgBase
-    {
-     public:
-        virtual inline ~ArgBase() {}
-        ArgBase() = default;
-        ArgBase(const ArgBase&) = default;
-        virtual const std::type_info& arg_type() const = 0;
-    };
-#pragma GCC diagnostic pop
-
-// ----------------------------------------------------------------------
-
+      // help text of an option, not copied, it must outlive the option
+      // (e.g. a string literal), a temporary std::string does not compile
     class Help
     {
      public:
-        inline Help() {}
-        template <typename Text> explicit inline Help(Text aMessage) : mMessage(aMessage) {}
-        inline bool has_message() const { return !mMessage.empty(); }
+        constexpr Help() {}
+        template <typename Text> explicit constexpr Help(const Text& aMessage) : mMessage(aMessage) {}
+        explicit Help(std::string&&) = delete;
+        explicit Help(const std::string&&) = delete;
+        constexpr bool has_message() const { return !mMessage.empty(); }
         friend inline std::ostream& operator << (std::ostream& out, const Help& aHelp) { return out << aHelp.mMessage; }
      private:
-        std::string mMessage;
+        std::string_view mMessage;
     };
 
 // ----------------------------------------------------------------------
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpadded"
-    template <typename ArgT> class Arg : public ArgBase
+    template <typename ArgT> struct _takes_value : public std::true_type {};
+    template <> struct _takes_value<bool> : public std::false_type {};
+    template <> struct _takes_value<Count> : public std::false_type {};
+    template <> struct _takes_value<PrintHelp> : public std::false_type {};
+
+    template <typename ArgT> struct _is_list : public std::false_type {};
+    template <typename T> struct _is_list<std::vector<T>> : public std::true_type {};
+
+      // type of elements of list options, type of other options
+    template <typename ArgT> struct _element { using type = ArgT; };
+    template <typename T> struct _element<std::vector<T>> { using type = T; };
+
+    template <typename ArgT> inline const char* _arg_type_name();
+    template <typename T> struct _list_type_name { static inline const std::string name = std::string(_arg_type_name<T>()) + ",..."; };
+
+      // type of option value shown in help and error messages
+    template <typename ArgT> inline const char* _arg_type_name()
+    {
+        if constexpr (_is_list<ArgT>::value)
+            return _list_type_name<typename ArgT::value_type>::name.c_str();
+        else
+            return typeid(ArgT).name();
+    }
+    template <> inline const char* _arg_type_name<bool>() { return ""; }
+    template <> inline const char* _arg_type_name<Count>() { return ""; }
+    template <> inline const char* _arg_type_name<PrintHelp>() { return ""; }
+    template <> inline const char* _arg_type_name<std::string>() { return "string"; }
+    template <> inline const char* _arg_type_name<std::string_view>() { return "string"; }
+    template <> inline const char* _arg_type_name<int>() { return "int"; }
+    template <> inline const char* _arg_type_name<unsigned>() { return "unsigned"; }
+    template <> inline const char* _arg_type_name<long>() { return "long"; }
+    template <> inline const char* _arg_type_name<unsigned long>() { return "unsigned long"; }
+    template <> inline const char* _arg_type_name<long long>() { return "long long"; }
+    template <> inline const char* _arg_type_name<float>() { return "float"; }
+    template <> inline const char* _arg_type_name<double>() { return "double"; }
+    template <> inline const char* _arg_type_name<long double>() { return "long double"; }
+
+      // std::string rvalue (deduced as Name&&), a long name view would dangle
+    template <typename Name> struct _is_temporary_string : public std::bool_constant<std::is_same<std::remove_const_t<Name>, std::string>::value> {};
+
+    template <typename R> ParseErrorCode _from_chars(std::string_view aValue, R& aResult);
+    template <typename T> ParseErrorCode _assign_list(std::vector<T>& aValues, std::string_view& aArg, char aDelimiter);
+
+      // Option description. The long name and help are views, they are
+      // not copied and must outlive the option (e.g. string literals),
+      // a temporary std::string as the long name does not compile.
+      // Arg is a literal type if ArgT is (numbers, bool, std::string_view,
+      // Count, PrintHelp), a specification of such options can be
+      // constexpr, see make_specification().
+    template <typename ArgT> class Arg
     {
      public:
-        inline Arg(char aShortName, std::string aLongName, const ArgT& aDefault, const Help& aHelp)
-            : mShortName(aShortName), mLongName(aLongName), mValue(aDefault), mHelp(aHelp) {}
-        inline Arg(char aShortName, const ArgT& aDefault, const Help& aHelp)
-            : mShortName(aShortName), mValue(aDefault), mHelp(aHelp) {}
-        inline Arg(std::string aLongName, const ArgT& aDefault, const Help& aHelp)
-            : mShortName(0), mLongName(aLongName), mValue(aDefault), mHelp(aHelp) {}
+        using value_type = ArgT;
 
-          // returns if value was consumed
-        template <typename NameT> std::pair<bool, bool> match_consume(NameT aName, const char* aValue)
-            {
-                auto r = std::make_pair(match(aName), false);
-                r.second  = r.first && consume(aValue);
-                return r;
-            }
+        constexpr Arg(char aShortName, std::string_view aLongName, const ArgT& aDefault, const Help& aHelp)
+            : mShortName(aShortName), mLongName(aLongName), mDefault(aDefault), mHelp(aHelp) {}
+        constexpr Arg(char aShortName, const ArgT& aDefault, const Help& aHelp)
+            : mShortName(aShortName), mDefault(aDefault), mHelp(aHelp) {}
+        constexpr Arg(std::string_view aLongName, const ArgT& aDefault, const Help& aHelp)
+            : mShortName(0), mLongName(aLongName), mDefault(aDefault), mHelp(aHelp) {}
+        template <typename Name, typename = std::enable_if_t<_is_temporary_string<Name>::value>> Arg(char, Name&&, const ArgT&, const Help&) = delete;
+        template <typename Name, typename = std::enable_if_t<_is_temporary_string<Name>::value>> Arg(Name&&, const ArgT&, const Help&) = delete;
 
-        inline bool match(std::string aName) const
+          // if option requires a value (bool, Count and PrintHelp options do not)
+        static constexpr bool takes_value = _takes_value<ArgT>::value;
+
+        inline bool match(std::string_view aName) const
             {
                 return aName == mLongName;
             }
@@ -126,17 +331,31 @@ namespace command_line_arguments
                 return aName == mShortName;
             }
 
-          // inline std::string name() const { return mLongName; }
-        inline const ArgT& value() const { return mValue; }
+        constexpr std::string_view long_name() const { return mLongName; }
+        constexpr char short_name() const { return mShortName; }
+        inline std::string name_s() const { return mLongName.empty() ? _option_name_s(mShortName) : _option_name_s(mLongName); }
+        constexpr const ArgT& default_value() const { return mDefault; }
+
+          // separator of values of Arg<std::vector<T>> options (default ','), e.g.
+          //   Arg<std::vector<int>>("ids", {}, Help()).delimiter(':')
+        constexpr Arg& delimiter(char aDelimiter) { mDelimiter = aDelimiter; return *this; }
+        constexpr char delimiter() const { return mDelimiter; }
 
-        friend inline std::ostream& operator << (std::ostream& out, const Arg<ArgT>& aArg)
+          // name=value
+        inline std::ostream& report(std::ostream& out, const ArgT& aValue) const
             {
-                if (aArg.mLongName.empty())
-                    out << aArg.mShortName;
+                if (mLongName.empty())
+                    out << mShortName;
                 else
-                    out << aArg.mLongName;
-                out << '=' << aArg.mValue;
-                return out;
+                    out << mLongName;
+                out << '=';
+                if constexpr (_is_list<ArgT>::value) {
+                    for (auto element = aValue.begin(); element != aValue.end(); ++element)
+                        out << (element == aValue.begin() ? "" : std::string(1, mDelimiter)) << *element;
+                    return out;
+                }
+                else
+                    return out << aValue;
             }
 
         inline std::string help() const
@@ -159,244 +378,2359 @@ namespace command_line_arguments
                 return out.str();
             }
 
-        virtual const std::type_info& arg_type() const { return typeid(ArgT); }
-        virtual std::string arg_type_s() const { return typeid(ArgT).name(); }
+        inline const std::type_info& arg_type() const { return typeid(ArgT); }
+        inline std::string arg_type_s() const { return _arg_type_name<ArgT>(); }
 
      private:
         char mShortName;
-        std::string mLongName;
-        ArgT mValue;
+        char mDelimiter = ',';
+        std::string_view mLongName;
+        ArgT mDefault;
         Help mHelp;
 
-        inline bool consume(const char* aValue)
-            {
-                if (aValue == nullptr)
-                    throw CommandLineError(std::string("Switch --") + mLongName + " requires a parameter, but end of command line arguments reached");
-                assign(aValue);
-                return true;
+        template <class ... Args> friend class Specification;
 
+          // updates aValue for the option found on the command line, on
+          // error aArg is narrowed to the part that cannot be converted
+        inline ParseErrorCode consume(ArgT& aValue, std::string_view& aArg) const
+            {
+                if constexpr (_is_list<ArgT>::value)
+                    return _assign_list(aValue, aArg, mDelimiter);
+                else
+                    return assign(aValue, aArg);
             }
 
-        inline void assign(const char* aValue)
+          // converts aArg, returns invalid_value or value_out_of_range if it cannot be converted
+        inline ParseErrorCode assign(ArgT& aValue, std::string_view aArg) const
             {
-                mValue = aValue;
+                aValue = aArg;
+                return ParseErrorCode::none;
             }
     };
 #pragma GCC diagnostic pop
 
-    template<> inline bool Arg<bool>::consume(const char*)
+    template<> inline ParseErrorCode Arg<bool>::consume(bool& aValue, std::string_view&) const
+    {
+        aValue = !aValue;           // just inverts value
+        return ParseErrorCode::none;
+    }
+
+    template<> inline ParseErrorCode Arg<bool>::assign(bool&, std::string_view) const
+    {
+        return ParseErrorCode::none; // nothing to assign
+    }
+
+    template<> inline ParseErrorCode Arg<Count>::consume(Count& aValue, std::string_view&) const
     {
-        mValue = !mValue;
-        return false;               // just inverts value
+        ++aValue;
+        return ParseErrorCode::none;
     }
 
-    template<> inline void Arg<bool>::assign(const char*)
+    template<> inline ParseErrorCode Arg<Count>::assign(Count&, std::string_view) const
     {
-          // nothing to assign
+        return ParseErrorCode::none; // nothing to assign
     }
 
-    template<> inline bool Arg<Count>::consume(const char*)
+    template<> inline ParseErrorCode Arg<PrintHelp>::consume(PrintHelp&, std::string_view&) const
     {
-        ++mValue;
-        return false;
+        return ParseErrorCode::help_requested; // usage message is mDefault
+    }
+
+    template<> inline ParseErrorCode Arg<PrintHelp>::assign(PrintHelp&, std::string_view) const
+    {
+        return ParseErrorCode::none; // nothing to assign
+    }
+
+      // Locale independent conversion of option values, the whole of
+      // aValue must be a number that fits into R. Leading white space and
+      // sign are accepted, integers can be decimal, 0x.. hexadecimal or
+      // 0.. octal (like strtol with base 0), floating point numbers can be
+      // 0x.. hexadecimal (like strtod). Nothing is allocated.
+    template <typename R> inline ParseErrorCode _from_chars(std::string_view aValue, R& aResult)
+    {
+        static_assert(std::is_arithmetic<R>::value && !std::is_same<R, bool>::value, "unsupported option value type");
+        const char* first = aValue.data();
+        const char* const last = first + aValue.size();
+        while (first != last && (*first == ' ' || (*first >= '\t' && *first <= '\r')))
+            ++first;
+        bool negative = false;
+        if (first != last && (*first == '+' || *first == '-'))
+            negative = *first++ == '-';
+        const bool hex = (last - first) > 2 && first[0] == '0' && (first[1] == 'x' || first[1] == 'X');
+        if (hex)
+            first += 2;
+        if (first == last || *first == '+' || *first == '-')
+            return ParseErrorCode::invalid_value;
+        if constexpr (std::is_integral<R>::value) {
+            using unsigned_t = std::make_unsigned_t<R>;
+            unsigned_t magnitude;
+            const int base = hex ? 16 : ((last - first) > 1 && first[0] == '0' ? 8 : 10);
+            const auto [end, error] = std::from_chars(first, last, magnitude, base);
+            if (error == std::errc::invalid_argument || end != last)
+                return ParseErrorCode::invalid_value;
+            if (error == std::errc::result_out_of_range)
+                return ParseErrorCode::value_out_of_range;
+            if (!negative) {
+                if (magnitude > static_cast<unsigned_t>(std::numeric_limits<R>::max()))
+                    return ParseErrorCode::value_out_of_range;
+                aResult = static_cast<R>(magnitude);
+            }
+            else if (magnitude == 0) {
+                aResult = 0;
+            }
+            else if constexpr (std::is_signed<R>::value) {
+                if (magnitude - 1 > static_cast<unsigned_t>(std::numeric_limits<R>::max()))
+                    return ParseErrorCode::value_out_of_range;
+                aResult = static_cast<R>(-static_cast<R>(magnitude - 1) - 1);
+            }
+            else {
+                return ParseErrorCode::value_out_of_range;
+            }
+        }
+        else {
+#ifdef __cpp_lib_to_chars
+            R value;
+            const auto [end, error] = std::from_chars(first, last, value, hex ? std::chars_format::hex : std::chars_format::general);
+            if (error == std::errc::invalid_argument || end != last)
+                return ParseErrorCode::invalid_value;
+            if (error == std::errc::result_out_of_range)
+                return ParseErrorCode::value_out_of_range;
+#else
+              // floating point from_chars is not available, strtod depends on locale
+            char buffer[128];
+            if (static_cast<std::size_t>(last - first) >= sizeof(buffer) - 2)
+                return ParseErrorCode::invalid_value;
+            char* const start = hex ? std::strcpy(buffer, "0x") + 2 : buffer;
+            std::memcpy(start, first, static_cast<std::size_t>(last - first));
+            start[last - first] = 0;
+            char* end;
+            errno = 0;
+            R value;
+            if constexpr (std::is_same<R, float>::value)
+                value = std::strtof(buffer, &end);
+            else if constexpr (std::is_same<R, double>::value)
+                value = std::strtod(buffer, &end);
+            else
+                value = std::strtold(buffer, &end);
+            if (end == buffer || *end != 0)
+                return ParseErrorCode::invalid_value;
+            if (errno == ERANGE)
+                return ParseErrorCode::value_out_of_range;
+#endif
+            aResult = negative ? -value : value;
+        }
+        return ParseErrorCode::none;
     }
 
-    template<> inline void Arg<Count>::assign(const char*)
+      // number of aChar in aText, 16 (SSE2) or 32 (AVX2) chars are compared at once
+    inline std::size_t _count_char(std::string_view aText, char aChar)
     {
-          // nothing to assign
+        const char* first = aText.data();
+        const char* const last = first + aText.size();
+        std::size_t count = 0;
+#ifdef COMMAND_LINE_ARGUMENTS_AVX2
+        for (const __m256i pattern = _mm256_set1_epi8(aChar); last - first >= 32; first += 32)
+            count += static_cast<std::size_t>(__builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first)), pattern)))));
+#endif
+#ifdef COMMAND_LINE_ARGUMENTS_SSE2
+        for (const __m128i pattern = _mm_set1_epi8(aChar); last - first >= 16; first += 16)
+            count += static_cast<std::size_t>(__builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(first)), pattern)))));
+#endif
+        for (; first != last; ++first)
+            count += *first == aChar;
+        return count;
     }
 
-    template<> inline bool Arg<PrintHelp>::consume(const char*)
+    template <typename T> inline ParseErrorCode _assign_element(T& aValue, std::string_view aArg)
     {
-        throw PrintHelp();
+        if constexpr (std::is_arithmetic<T>::value) {
+            return _from_chars(aArg, aValue);
+        }
+        else {
+            aValue = T(aArg);
+            return ParseErrorCode::none;
+        }
     }
 
-    template<> inline void Arg<PrintHelp>::assign(const char*)
+      // Appends elements of aArg separated by aDelimiter to aValues,
+      // storage is reserved once. Empty aArg adds no elements. On error
+      // aArg is narrowed to the element that cannot be converted.
+    template <typename T> inline ParseErrorCode _assign_list(std::vector<T>& aValues, std::string_view& aArg, char aDelimiter)
     {
-          // nothing to assign
+        if (aArg.empty())
+            return ParseErrorCode::none;
+        if (const std::size_t size = aValues.size() + _count_char(aArg, aDelimiter) + 1; size > aValues.capacity())
+            aValues.reserve(std::max(size, aValues.capacity() * 2)); // repeated switches: keep growth geometric
+        const char* first = aArg.data();
+        const char* const last = first + aArg.size();
+        for (;;) {
+            const char* end = static_cast<const char*>(std::memchr(first, aDelimiter, static_cast<std::size_t>(last - first)));
+            if (end == nullptr)
+                end = last;
+            const std::string_view element(first, static_cast<std::size_t>(end - first));
+            if (const ParseErrorCode code = _assign_element(aValues.emplace_back(), element); code != ParseErrorCode::none) {
+                aValues.pop_back();
+                aArg = element;
+                return code;
+            }
+            if (end == last)
+                return ParseErrorCode::none;
+            first = end + 1;
+        }
     }
 
-    template <typename R, typename FF, typename S> inline void _extract_from_string(const char* aValue, FF F, S type, R& aResult)
+      // FNV-1a, used to build and probe the long option table
+    constexpr std::size_t _hash_name(const char* aFirst, const char* aLast)
     {
-        char* end;
-        const R result = static_cast<R>(F(aValue, &end));
-        if (end == aValue || *end != 0)
-            throw CommandLineError(std::string("Cannot parse \"") + aValue + "\" as " + type);
-        aResult = result;
+        std::uint32_t hash = 2166136261u;
+        for (; aFirst != aLast; ++aFirst)
+            hash = (hash ^ static_cast<unsigned char>(*aFirst)) * 16777619u;
+        return hash;
     }
 
-    template<> inline std::string Arg<bool>::arg_type_s() const { return std::string(); }
-    template<> inline std::string Arg<Count>::arg_type_s() const { return std::string(); }
-    template<> inline std::string Arg<PrintHelp>::arg_type_s() const { return std::string(); }
-    template<> inline std::string Arg<std::string>::arg_type_s() const { return "string"; }
-    template<> inline std::string Arg<int>::arg_type_s() const { return "int"; }
-    template<> inline std::string Arg<unsigned>::arg_type_s() const { return "unsigned"; }
-    template<> inline std::string Arg<long>::arg_type_s() const { return "long"; }
-    template<> inline std::string Arg<unsigned long>::arg_type_s() const { return "unsigned long"; }
-    template<> inline std::string Arg<long long>::arg_type_s() const { return "long long"; }
-    template<> inline std::string Arg<float>::arg_type_s() const { return "float"; }
-    template<> inline std::string Arg<double>::arg_type_s() const { return "double"; }
-    template<> inline std::string Arg<long double>::arg_type_s() const { return "long double"; }
-
-    template<> inline void Arg<int>::assign(const char* aValue)  { _extract_from_string(aValue, std::bind(std::strtol, std::placeholders::_1, std::placeholders::_2, 0), arg_type_s(), mValue); }
-    template<> inline void Arg<unsigned>::assign(const char* aValue)  { _extract_from_string(aValue, std::bind(std::strtoul, std::placeholders::_1, std::placeholders::_2, 0), arg_type_s(), mValue); }
-    template<> inline void Arg<long>::assign(const char* aValue) { _extract_from_string(aValue, std::bind(std::strtol, std::placeholders::_1, std::placeholders::_2, 0), arg_type_s(), mValue); }
-    template<> inline void Arg<unsigned long>::assign(const char* aValue) { _extract_from_string(aValue, std::bind(std::strtoul, std::placeholders::_1, std::placeholders::_2, 0), arg_type_s(), mValue); }
-    template<> inline void Arg<long long>::assign(const char* aValue) { _extract_from_string(aValue, std::bind(std::strtoll, std::placeholders::_1, std::placeholders::_2, 0), arg_type_s(), mValue); }
-    template<> inline void Arg<float>::assign(const char* aValue)  { _extract_from_string(aValue, std::strtof, arg_type_s(), mValue); }
-    template<> inline void Arg<double>::assign(const char* aValue)  { _extract_from_string(aValue, std::strtod, arg_type_s(), mValue); }
-    template<> inline void Arg<long double>::assign(const char* aValue)  { _extract_from_string(aValue, std::strtold, arg_type_s(), mValue); }
+
+    template<> inline ParseErrorCode Arg<int>::assign(int& aValue, std::string_view aArg) const { return _from_chars(aArg, aValue); }
+    template<> inline ParseErrorCode Arg<unsigned>::assign(unsigned& aValue, std::string_view aArg) const { return _from_chars(aArg, aValue); }
+    template<> inline ParseErrorCode Arg<long>::assign(long& aValue, std::string_view aArg) const { return _from_chars(aArg, aValue); }
+    template<> inline ParseErrorCode Arg<unsigned long>::assign(unsigned long& aValue, std::string_view aArg) const { return _from_chars(aArg, aValue); }
+    template<> inline ParseErrorCode Arg<long long>::assign(long long& aValue, std::string_view aArg) const { return _from_chars(aArg, aValue); }
+    template<> inline ParseErrorCode Arg<float>::assign(float& aValue, std::string_view aArg) const { return _from_chars(aArg, aValue); }
+    template<> inline ParseErrorCode Arg<double>::assign(double& aValue, std::string_view aArg) const { return _from_chars(aArg, aValue); }
+    template<> inline ParseErrorCode Arg<long double>::assign(long double& aValue, std::string_view aArg) const { return _from_chars(aArg, aValue); }
+
+// ----------------------------------------------------------------------
+
+      // typed handle of an option, i.e. its index in CommandLineArguments, see CommandLineArguments::handles()
+    template <std::size_t Ind> struct Handle
+    {
+        static constexpr std::size_t index = Ind;
+    };
 
 // ----------------------------------------------------------------------
 
-    template <class ... Args> class CommandLineArguments : public std::tuple<Args...>
+      // Elements of Tuple are its bases indexed by position: access by
+      // index is a lookup of the base, not a recursive instantiation
+      // (std::tuple nests one level per element and exceeds the template
+      // depth limit with about 900 options).
+    template <std::size_t Ind, typename T> struct _TupleLeaf { T value{}; };
+
+    template <std::size_t Ind, typename T> constexpr T& _get(_TupleLeaf<Ind, T>& aLeaf) { return aLeaf.value; }
+    template <std::size_t Ind, typename T> constexpr const T& _get(const _TupleLeaf<Ind, T>& aLeaf) { return aLeaf.value; }
+    template <std::size_t Ind, typename T> T _leaf_type(const _TupleLeaf<Ind, T>&);
+
+    template <typename Inds, typename ... Ts> struct _TupleBase;
+    template <std::size_t ... Inds, typename ... Ts> struct _TupleBase<std::index_sequence<Inds...>, Ts...> : public _TupleLeaf<Inds, Ts> ...
+    {
+        constexpr _TupleBase() = default;
+        constexpr _TupleBase(std::in_place_t, const Ts& ... aValues) : _TupleLeaf<Inds, Ts>{aValues} ... {}
+    };
+
+    template <std::size_t Ind, typename ... Ts> using _tuple_element_t = decltype(_leaf_type<Ind>(std::declval<const _TupleBase<std::index_sequence_for<Ts...>, Ts...>&>()));
+
+      // Tuple of option values (ParseResult::values()), options
+      // (Specification) and handles (handles()), supports structured
+      // bindings. Elements can also be accessed by index at run time with
+      // at<T>(), type erased code (one routine per option type) uses it.
+    template <typename ... Ts> class Tuple : public _TupleBase<std::index_sequence_for<Ts...>, Ts...>
     {
      public:
-        inline CommandLineArguments(const Args&... a)
-            : std::tuple<Args...>(std::forward_as_tuple(a...)), mMinArgs(0), mMaxArgs(std::size_t(-1)) {}
+        constexpr Tuple() = default;
+        template <typename ... Us, typename = std::enable_if_t<sizeof...(Us) == sizeof...(Ts) && (sizeof...(Us) > 0)>> constexpr Tuple(const Us& ... aValues)
+            : _TupleBase<std::index_sequence_for<Ts...>, Ts...>(std::in_place, aValues...) {}
+
+        static constexpr std::size_t size() { return sizeof...(Ts); }
+        template <std::size_t Ind> constexpr auto& get() { return _get<Ind>(*this); }
+        template <std::size_t Ind> constexpr const auto& get() const { return _get<Ind>(*this); }
+
+          // element at aIndex, T must be its type
+        template <typename T> inline T& at(std::size_t aIndex) { return *reinterpret_cast<T*>(reinterpret_cast<char*>(this) + offset(aIndex)); }
+        template <typename T> inline const T& at(std::size_t aIndex) const { return *reinterpret_cast<const T*>(reinterpret_cast<const char*>(this) + offset(aIndex)); }
 
-        inline void min_max(std::size_t aMinArgs, std::size_t aMaxArgs = std::size_t(-1))
+     private:
+        inline std::size_t offset(std::size_t aIndex) const { return offsets(std::index_sequence_for<Ts...>{})[aIndex]; }
+
+        template <std::size_t ... Inds> inline const std::size_t* offsets(std::index_sequence<Inds...>) const
             {
-                mMinArgs = aMinArgs;
-                mMaxArgs = aMaxArgs;
+                  // the same for all objects of the type, taken from the first one
+                static const std::size_t offsets[] = {static_cast<std::size_t>(reinterpret_cast<const char*>(&_get<Inds>(*this)) - reinterpret_cast<const char*>(this)) ..., 0};
+                return offsets;
             }
+    };
 
-        void parse(int argc, const char *argv[])
-            {
-                mProgramName = argv[0];
-                try {
-                    for (int arg_no = 1; arg_no < argc; ++arg_no) {
-                        if (argv[arg_no][0] == '-' && argv[arg_no][1] != 0) { // single - is not an option, it is stdin or stdout
-                            if (argv[arg_no][1] == '-') {
-                                  // support for long option and its value separated by =
-                                const char* eq_sign = std::strchr(argv[arg_no] + 2, '=');
-                                const char* arg_arg;
-                                std::string name;
-                                if (eq_sign == nullptr) {
-                                    arg_arg = (arg_no + 1) < argc ? argv[arg_no + 1] : nullptr;
-                                    name = argv[arg_no] + 2;
-                                }
-                                else {
-                                    arg_arg = eq_sign + 1;
-                                    name.assign(argv[arg_no] + 2, eq_sign);
-                                }
-                                const bool advance_arg_no_on_consumption = eq_sign == nullptr;
-                                const auto found_consumed = set_arg(name, arg_arg, std::index_sequence_for<Args...>{});
-                                if (!found_consumed.first)
-                                    throw CommandLineError(std::string("Unrecognized long option ") + argv[arg_no]);
-                                if (advance_arg_no_on_consumption && found_consumed.second)
-                                    ++arg_no;
-                            }
-                            else {
-                                for (auto arg_pos = 1; argv[arg_no][arg_pos] != 0; ++arg_pos) {
-                                    auto arg_arg = argv[arg_no][arg_pos + 1] != 0 ? (argv[arg_no] + arg_pos + 1) : ((arg_no + 1) < argc ? argv[arg_no + 1] : nullptr);
-                                    const auto found_consumed = set_arg(argv[arg_no][arg_pos], arg_arg, std::index_sequence_for<Args...>{});
-                                    if (!found_consumed.first)
-                                        throw CommandLineError(std::string("Unrecognized short option -") + std::string(1, argv[arg_no][arg_pos]));
-                                    if (found_consumed.second) {
-                                        if (arg_arg == argv[arg_no + 1])
-                                            ++arg_no;
-                                        break;
-                                    }
-                                }
-                            }
-                        }
-                        else {
-                            mArgs.push_back(argv[arg_no]);
+    template <std::size_t Ind, typename ... Ts> constexpr auto& get(Tuple<Ts...>& aTuple) { return _get<Ind>(aTuple); }
+    template <std::size_t Ind, typename ... Ts> constexpr const auto& get(const Tuple<Ts...>& aTuple) { return _get<Ind>(aTuple); }
+
+// ----------------------------------------------------------------------
+
+      // how @file tokens are handled by parse(), see CommandLineArguments::response_files()
+    enum class ResponseFiles
+    {
+        off,                    // @file is a positional argument
+        quoted,                 // tokens in the file are separated by white space, '...', "..." and \\ quoting is supported
+        null_separated          // tokens in the file are separated by nul chars, e.g. generated by find -print0
+    };
+
+      // when values of options are converted, see Specification::conversion()
+    enum class Conversion
+    {
+        eager,                  // during parse
+        lazy                    // on the first get() or by validate_all()
+    };
+
+      // read-only view of a response file contents, memory mapped when
+      // possible. If the file cannot be read, failed() returns the failed
+      // operation ("open", "map" or "read") and error() its errno.
+    class MappedFile
+    {
+     public:
+        explicit inline MappedFile(const std::string& aPath);
+        inline ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator = (const MappedFile&) = delete;
+
+        inline std::string_view data() const { return {mData, mSize}; }
+        inline const char* failed() const { return mFailed; }
+        inline int error() const { return mError; }
+
+          // lets the system drop mapped pages before aUpTo from memory, the
+          // contents stay valid and is read from the file again on access
+        inline void release(const char* aUpTo);
+
+     private:
+        const char* mData;
+        std::size_t mSize;
+        bool mMapped;
+        const char* mFailed = nullptr;
+        int mError = 0;
+        std::size_t mReleased = 0;
+        std::string mBuffer;    // contents of pipes and other files that cannot be mapped
+    };
+
+#ifdef COMMAND_LINE_ARGUMENTS_MMAP
+
+    inline MappedFile::MappedFile(const std::string& aPath)
+        : mData(nullptr), mSize(0), mMapped(false)
+    {
+        const int fd = ::open(aPath.c_str(), O_RDONLY);
+        if (fd < 0) {
+            mFailed = "open";
+            mError = errno;
+            return;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            mSize = static_cast<std::size_t>(st.st_size);
+            if (mSize > 0) {
+                void* data = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data == MAP_FAILED) {
+                    mFailed = "map";
+                    mError = errno;
+                    mSize = 0;
+                    ::close(fd);
+                    return;
+                }
+                ::madvise(data, mSize, MADV_SEQUENTIAL);
+                mData = static_cast<const char*>(data);
+                mMapped = true;
+            }
+        }
+        else {
+            char chunk[65536];
+            for (ssize_t read = 0; (read = ::read(fd, chunk, sizeof(chunk))) != 0; ) {
+                if (read < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    mFailed = "read";
+                    mError = errno;
+                    break;
+                }
+                mBuffer.append(chunk, static_cast<std::size_t>(read));
+            }
+            mData = mBuffer.data();
+            mSize = mBuffer.size();
+        }
+        ::close(fd);
+    }
+
+    inline MappedFile::~MappedFile()
+    {
+        if (mMapped)
+            ::munmap(const_cast<char*>(mData), mSize);
+    }
+
+    inline void MappedFile::release(const char* aUpTo)
+    {
+        constexpr std::size_t release_chunk = 32 * 1024 * 1024;
+        const std::size_t up_to = static_cast<std::size_t>(aUpTo - mData);
+        if (mMapped && up_to >= mReleased + release_chunk) {
+            const std::size_t end = up_to & ~(static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) - 1);
+            ::madvise(const_cast<char*>(mData) + mReleased, end - mReleased, MADV_DONTNEED);
+            mReleased = end;
+        }
+    }
+
+#else
+
+    inline MappedFile::MappedFile(const std::string& aPath)
+        : mData(nullptr), mSize(0), mMapped(false)
+    {
+        std::ifstream input(aPath, std::ios::binary);
+        if (!input) {
+            mFailed = "open";
+            return;
+        }
+        mBuffer.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        mData = mBuffer.data();
+        mSize = mBuffer.size();
+    }
+
+    inline MappedFile::~MappedFile()
+    {
+    }
+
+    inline void MappedFile::release(const char*)
+    {
+    }
+
+#endif
+
+// ----------------------------------------------------------------------
+
+      // Splits response file contents or a command line string into
+      // tokens on demand. Tokens are views of aData, only tokens with
+      // quotes or escapes are unquoted into aUnquoted. If aRelease is set,
+      // pages of the file that were tokenized are released from memory as
+      // tokenizing proceeds. next() returns false on unterminated quote,
+      // unterminated() is then the rest of aData starting with that token.
+    class ResponseFileTokenizer
+    {
+     public:
+        inline ResponseFileTokenizer(std::string_view aData, ResponseFiles aMode, std::deque<std::string>& aUnquoted, MappedFile* aRelease = nullptr)
+            : mCurrent(aData.data()), mEnd(aData.data() + aData.size()), mMode(aMode), mUnquoted(aUnquoted), mRelease(aRelease) {}
+
+        inline std::string_view unterminated() const { return mUnterminated; }
+
+          // streaming parse: releases the unquoted copy of aToken (the last
+          // token returned by next()) if it was made
+        inline void drop_unquoted(std::string_view aToken)
+            {
+                if (!mUnquoted.empty() && aToken.data() == mUnquoted.back().data())
+                    mUnquoted.pop_back();
+            }
+
+        inline bool next(std::string_view& aToken)
+            {
+                if (mRelease != nullptr)
+                    mRelease->release(mCurrent);
+                if (mMode == ResponseFiles::null_separated) {
+                    while (mCurrent != mEnd && *mCurrent == 0)
+                        ++mCurrent;
+                    if (mCurrent == mEnd)
+                        return false;
+                    const char* end = static_cast<const char*>(std::memchr(mCurrent, 0, static_cast<std::size_t>(mEnd - mCurrent)));
+                    if (end == nullptr)
+                        end = mEnd;
+                    aToken = std::string_view(mCurrent, static_cast<std::size_t>(end - mCurrent));
+                    mCurrent = end;
+                    return true;
+                }
+                while (mCurrent != mEnd && char_class(*mCurrent) == space)
+                    ++mCurrent;
+                if (mCurrent == mEnd)
+                    return false;
+                const char* const start = mCurrent;
+                mCurrent = find_special(mCurrent, mEnd);
+                if (mCurrent == mEnd || char_class(*mCurrent) == space)
+                    aToken = std::string_view(start, static_cast<std::size_t>(mCurrent - start));
+                else if (!unquote(start, aToken))
+                    return false;
+                return true;
+            }
+
+     private:
+        const char* mCurrent;
+        const char* mEnd;
+        ResponseFiles mMode;
+        std::deque<std::string>& mUnquoted;
+        MappedFile* mRelease;
+        std::string_view mUnterminated;
+
+        enum char_class_t : unsigned char { regular, space, quote };
+
+        static inline char_class_t char_class(char aChar)
+            {
+                struct table_t
+                {
+                    constexpr table_t() : classes{}
+                        {
+                            for (unsigned char ch: {' ', '\n', '\t', '\r', '\f', '\v'})
+                                classes[ch] = space;
+                            for (unsigned char ch: {'\'', '"', '\\'})
+                                classes[ch] = quote;
                         }
+                    char_class_t classes[256];
+                };
+                static constexpr table_t table;
+                return table.classes[static_cast<unsigned char>(aChar)];
+            }
+
+          // first space or quote char in [aFirst, aLast) or aLast, 16 or 32
+          // chars are checked at once if SSE2 or AVX2 is available
+        static inline const char* find_special(const char* aFirst, const char* aLast)
+            {
+#ifdef COMMAND_LINE_ARGUMENTS_AVX2
+                if (aLast - aFirst >= 32) {
+                    const __m256i nine = _mm256_set1_epi8(9), four = _mm256_set1_epi8(4), blank = _mm256_set1_epi8(' '),
+                            single_quote = _mm256_set1_epi8('\''), double_quote = _mm256_set1_epi8('"'), backslash = _mm256_set1_epi8('\\');
+                    for (; aLast - aFirst >= 32; aFirst += 32) {
+                        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aFirst));
+                        const __m256i control = _mm256_sub_epi8(chunk, nine); // \t \n \v \f \r are 9..13
+                        const __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(control, four), control), _mm256_cmpeq_epi8(chunk, blank)),
+                                                                _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, single_quote), _mm256_cmpeq_epi8(chunk, double_quote)), _mm256_cmpeq_epi8(chunk, backslash)));
+                        if (const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(special)); mask != 0)
+                            return aFirst + __builtin_ctz(mask);
                     }
-                    if (mArgs.size() < mMinArgs)
-                        throw CommandLineError("Too few arguments provided");
-                    if (mArgs.size() > mMaxArgs)
-                        throw CommandLineError("Too many arguments provided");
                 }
-                catch (PrintHelp& help) {
-                    print_help(std::cerr, &help);
-                    exit(1);
+#endif
+#ifdef COMMAND_LINE_ARGUMENTS_SSE2
+                if (aLast - aFirst >= 16) {
+                    const __m128i nine = _mm_set1_epi8(9), four = _mm_set1_epi8(4), blank = _mm_set1_epi8(' '),
+                            single_quote = _mm_set1_epi8('\''), double_quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\');
+                    for (; aLast - aFirst >= 16; aFirst += 16) {
+                        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aFirst));
+                        const __m128i control = _mm_sub_epi8(chunk, nine); // \t \n \v \f \r are 9..13
+                        const __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(control, four), control), _mm_cmpeq_epi8(chunk, blank)),
+                                                             _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, single_quote), _mm_cmpeq_epi8(chunk, double_quote)), _mm_cmpeq_epi8(chunk, backslash)));
+                        if (const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special)); mask != 0)
+                            return aFirst + __builtin_ctz(mask);
+                    }
                 }
+#endif
+                while (aFirst != aLast && char_class(*aFirst) == regular)
+                    ++aFirst;
+                return aFirst;
             }
 
-        inline void print_help(std::ostream& out, const PrintHelp* aHelp = nullptr)
+          // POSIX shell quote removal: \c is c (\newline is removed,
+          // trailing \ is kept),
+          // '...' is literal, in "..." backslash escapes only " \ $ ` and
+          // newline. Unquoted runs are appended at once.
+        inline bool unquote(const char* aStart, std::string_view& aToken)
             {
-                if (aHelp == nullptr) {
-                    try {
-                        aHelp = &get<PrintHelp>("help");
-                    }
-                    catch (CommandLineError&) {
-                        aHelp = new PrintHelp();
+                std::string& token = mUnquoted.emplace_back(aStart, mCurrent);
+                while (mCurrent != mEnd && char_class(*mCurrent) != space) {
+                    switch (*mCurrent) {
+                      case '\\':
+                          if (++mCurrent == mEnd)
+                              token.push_back('\\');
+                          else if (*mCurrent++ != '\n')
+                              token.push_back(mCurrent[-1]);
+                          break;
+                      case '\'': {
+                          const char* const close = static_cast<const char*>(std::memchr(mCurrent + 1, '\'', static_cast<std::size_t>(mEnd - mCurrent - 1)));
+                          if (close == nullptr)
+                              return unterminated(aStart);
+                          token.append(mCurrent + 1, close);
+                          mCurrent = close + 1;
+                          break;
+                      }
+                      case '"':
+                          for (++mCurrent; mCurrent != mEnd && *mCurrent != '"'; ++mCurrent) {
+                              if (*mCurrent == '\\' && (mCurrent + 1) != mEnd && mCurrent[1] != 0 && std::strchr("\"\\$`\n", mCurrent[1]) != nullptr) {
+                                  if (*++mCurrent == '\n')
+                                      continue;
+                              }
+                              token.push_back(*mCurrent);
+                          }
+                          if (mCurrent == mEnd)
+                              return unterminated(aStart);
+                          ++mCurrent;
+                          break;
+                      default: {
+                          const char* const end = find_special(mCurrent, mEnd);
+                          token.append(mCurrent, end);
+                          mCurrent = end;
+                          break;
+                      }
                     }
                 }
-                out << aHelp->message(mProgramName) << std::endl << "Options:" << std::endl;
-                help_helper(out, std::index_sequence_for<Args...>{});
+                aToken = token;
+                return true;
             }
 
-        template <typename ArgT, typename NameT> inline const ArgT& get(NameT aName) const
+        inline bool unterminated(const char* aStart)
             {
-                return get_helper<ArgT>(aName, std::index_sequence_for<Args...>{});
+                mUnquoted.pop_back();
+                mUnterminated = std::string_view(aStart, static_cast<std::size_t>(mEnd - aStart));
+                mCurrent = mEnd;
+                return false;
             }
+    };
 
-        void report(std::ostream& out) const
+// ----------------------------------------------------------------------
+
+      // positional arguments, elements are views of the argv strings or,
+      // if response files were used, of the response file contents
+    class Arguments
+    {
+     public:
+        class const_iterator
+        {
+         public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = std::string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::string_view*;
+            using reference = std::string_view;
+
+            inline const_iterator(const Arguments* aArgs = nullptr, std::size_t aArgNo = 0) : mArgs(aArgs), mArgNo(aArgNo) {}
+            inline std::string_view operator * () const { return (*mArgs)[mArgNo]; }
+            inline std::string_view operator [] (difference_type aOffset) const { return (*mArgs)[mArgNo + static_cast<std::size_t>(aOffset)]; }
+            inline const_iterator& operator ++ () { ++mArgNo; return *this; }
+            inline const_iterator operator ++ (int) { return {mArgs, mArgNo++}; }
+            inline const_iterator& operator -- () { --mArgNo; return *this; }
+            inline const_iterator operator -- (int) { return {mArgs, mArgNo--}; }
+            inline const_iterator& operator += (difference_type aOffset) { mArgNo += static_cast<std::size_t>(aOffset); return *this; }
+            inline const_iterator operator + (difference_type aOffset) const { return {mArgs, mArgNo + static_cast<std::size_t>(aOffset)}; }
+            inline const_iterator operator - (difference_type aOffset) const { return {mArgs, mArgNo - static_cast<std::size_t>(aOffset)}; }
+            inline difference_type operator - (const_iterator aOther) const { return static_cast<difference_type>(mArgNo - aOther.mArgNo); }
+            inline bool operator == (const_iterator aOther) const { return mArgNo == aOther.mArgNo; }
+            inline bool operator != (const_iterator aOther) const { return mArgNo != aOther.mArgNo; }
+            inline bool operator < (const_iterator aOther) const { return mArgNo < aOther.mArgNo; }
+
+         private:
+            const Arguments* mArgs;
+            std::size_t mArgNo;
+        };
+
+        inline Arguments() : mArgv(nullptr), mViews(nullptr), mSize(0) {}
+        inline Arguments(const char* const* aFirst, std::size_t aSize) : mArgv(aFirst), mViews(nullptr), mSize(aSize) {}
+        inline Arguments(const std::string_view* aFirst, std::size_t aSize) : mArgv(nullptr), mViews(aFirst), mSize(aSize) {}
+
+        inline std::size_t size() const { return mSize; }
+        inline bool empty() const { return mSize == 0; }
+        inline std::string_view operator [] (std::size_t aArgNo) const { return mViews != nullptr ? mViews[aArgNo] : std::string_view(mArgv[aArgNo]); }
+        inline const_iterator begin() const { return {this, 0}; }
+        inline const_iterator end() const { return {this, mSize}; }
+
+     private:
+        const char* const* mArgv;
+        const std::string_view* mViews;
+        std::size_t mSize;
+    };
+
+// ----------------------------------------------------------------------
+
+      // Positional argument callback for the streaming parse(), collects
+      // arguments into batches of aBatchSize and hands each full batch
+      // (std::vector<std::string_view>&&) to aExecutor, e.g. to submit it
+      // to a thread pool while parsing continues. Call flush() after
+      // parse() to hand off the last incomplete batch. Views of response
+      // file arguments with quotes are kept until the next parse.
+    template <typename Executor> class ArgBatches
+    {
+     public:
+        inline ArgBatches(std::size_t aBatchSize, Executor aExecutor)
+            : mBatchSize(aBatchSize), mExecutor(std::move(aExecutor)) { mBatch.reserve(mBatchSize); }
+
+        inline void operator () (std::string_view aArg)
             {
-                report_helper(out, std::index_sequence_for<Args...>{}, " ");
-                out << std::endl;
-                out << "ARGS (" << mArgs.size() << "):";
-                for (auto arg: mArgs)
-                    out << ' ' << arg;
+                mBatch.push_back(aArg);
+                if (mBatch.size() >= mBatchSize)
+                    flush();
             }
 
-        inline std::string arg(std::size_t aArgNo) const
+        inline void flush()
             {
-                return mArgs[aArgNo];
+                if (!mBatch.empty()) {
+                    mExecutor(std::move(mBatch));
+                    mBatch = std::vector<std::string_view>();
+                    mBatch.reserve(mBatchSize);
+                }
             }
 
      private:
-        std::string mProgramName;
-        std::vector<std::string> mArgs;
-        std::size_t mMinArgs, mMaxArgs;
+        std::size_t mBatchSize;
+        Executor mExecutor;
+        std::vector<std::string_view> mBatch;
+    };
+
+    template <typename Executor> inline ArgBatches<Executor> make_arg_batches(std::size_t aBatchSize, Executor aExecutor)
+    {
+        return ArgBatches<Executor>(aBatchSize, std::move(aExecutor));
+    }
+
+      // streaming parse() callbacks that use views of arguments after they return
+    template <typename OnArg> struct _keeps_arg_views : public std::false_type {};
+    template <typename Executor> struct _keeps_arg_views<ArgBatches<Executor>> : public std::true_type {};
+
+      // positional argument callback of the streaming parse()
+    template <typename OnArg> struct _StreamArg
+    {
+        OnArg& on_arg;
+        template <typename Source> inline void operator () (Source&, std::string_view aArg) const { on_arg(aArg); }
+    };
+
+      // unquoted copies of response file arguments are released after the callback
+    template <typename OnArg> struct _drops_unquoted : public std::false_type {};
+    template <typename OnArg> struct _drops_unquoted<_StreamArg<OnArg>> : public std::bool_constant<!_keeps_arg_views<std::decay_t<OnArg>>::value> {};
+
+// ----------------------------------------------------------------------
+
+      // token source of parse(): argv[next_no, argc)
+    struct ArgvTokens
+    {
+        const char** argv;
+        int argc;
+        int next_no;
+
+        inline bool next(std::string_view& aToken)
+            {
+                if (next_no >= argc)
+                    return false;
+                aToken = argv[next_no++];
+                return true;
+            }
+    };
+
+      // rest of the token source starting with an unterminated quote, empty if tokens ended normally
+    template <typename Source> inline std::string_view _unterminated(const Source&) { return std::string_view(); }
+    inline std::string_view _unterminated(const ResponseFileTokenizer& aSource) { return aSource.unterminated(); }
+
+// ----------------------------------------------------------------------
+
+      // Instrumentation policies of parse results, chosen at compile
+      // time: with NoStatistics (the default) nothing is collected and
+      // parse() is compiled without any instrumentation, with
+      // CollectStatistics each parse updates the ParseStatistics of the
+      // result (see BasicParseResult::statistics()).
+    struct NoStatistics { static constexpr bool enabled = false; };
+    struct CollectStatistics { static constexpr bool enabled = true; };
 
-          // returns pair <match found, next argv was consumed>
-        template <typename NameT, std::size_t ... Inds> inline std::pair<bool, bool> set_arg(NameT aName, const char* aNextArgv, std::index_sequence<Inds...>)
+    template <typename Policy, class ... Args> class BasicParseResult;
+    template <class ... Args> using ParseResult = BasicParseResult<NoStatistics, Args...>;
+    template <class ... Args> class BatchResult;
+    template <class ... Args> class ParseStatistics;
+    template <class ... Commands> class Subcommands;
+
+      // Description of options: names, defaults, help. After setting up
+      // with min_max() and response_files() it is not modified, parse() is
+      // const and can be called concurrently from many threads, each
+      // parse filling its own ParseResult.
+      // If all option types are literal types, the specification
+      // (including its lookup tables) can be built at compile time, see
+      // make_specification().
+    template <class ... Args> class Specification : public Tuple<Args...>
+    {
+     public:
+        using result_type = ParseResult<Args...>;
+        template <typename Policy> using basic_result_type = BasicParseResult<Policy, Args...>;
+
+        constexpr Specification(const Args&... a)
+            : Tuple<Args...>(a...), mMinArgs(0), mMaxArgs(std::size_t(-1))
             {
-                const std::pair<bool, bool> consumed[] = {std::get<Inds>(*this).match_consume(aName, aNextArgv) ...};
-                const auto found = std::find_if(std::begin(consumed), std::end(consumed), [](auto v) { return v.first; });
-                return found != std::end(consumed) ? *found : std::make_pair(false, false);
+                make_tables(std::index_sequence_for<Args...>{});
             }
 
-        template <typename ArgT, typename NameT, std::size_t ... Inds> const ArgT& get_helper(NameT aName, std::index_sequence<Inds...>) const
+        constexpr Specification& min_max(std::size_t aMinArgs, std::size_t aMaxArgs = std::size_t(-1))
             {
-                const ArgBase* values[] = {(std::get<Inds>(*this).match(aName) ? &std::get<Inds>(*this) : nullptr) ...};
-                for (auto p: values) {
-                    if (p != nullptr) {
-                        auto arg = dynamic_cast<const Arg<ArgT>*>(p);
-                        if (arg == nullptr)
-                            throw CommandLineError(std::string("Invalid type of option ") + aName + " requested using get(): " + typeid(ArgT).name() + ", real type is " + p->arg_type().name());
-                        return arg->value();
-                    }
-                }
-                throw CommandLineError(std::string("Cannot find option ") + aName);
+                mMinArgs = aMinArgs;
+                mMaxArgs = aMaxArgs;
+                return *this;
             }
 
-        template <std::size_t ... Inds> inline void report_helper(std::ostream& out, std::index_sequence<Inds...>, const char* aSeparator) const
+          // @file tokens are expanded if enabled, tokens in the file are
+          // processed as if they were in argv
+        constexpr Specification& response_files(ResponseFiles aMode)
             {
-                int unused[] = {(out << (Inds == 0 ? "" : aSeparator) << std::get<Inds>(*this), 0) ...};
-                (void)unused;
+                mResponseFiles = aMode;
+                return *this;
             }
 
-        template <std::size_t ... Inds> inline void help_helper(std::ostream& out, std::index_sequence<Inds...>) const
+          // In Conversion::lazy mode parse records only the last value of
+          // each option (an earlier value of a repeated option is checked
+          // when it is replaced and kept if invalid), it is converted (and
+          // validated) on the first get() and cached. Errors are then reported by get() (throws
+          // CommandLineError) or by ParseResult::validate_all(). Values of
+          // list, bool, Count and PrintHelp options are always processed
+          // during parse.
+        constexpr Specification& conversion(Conversion aConversion)
             {
-                int unused[] = {(out << "  " << std::get<Inds>(*this).help() << std::endl, 0) ...};
-                (void)unused;
+                mConversion = aConversion;
+                return *this;
             }
 
-    };
+          // getopt_long style abbreviations (on by default): --verb is
+          // --verbose if no other long name starts with "verb", a full
+          // name always wins, otherwise ParseErrorCode::ambiguous_long_option
+        constexpr Specification& abbreviations(bool aAbbreviations)
+            {
+                mAbbreviations = aAbbreviations;
+                return *this;
+            }
 
-    template <class ... Args> std::unique_ptr<CommandLineArguments<Args...>> make_command_line_arguments(const Args& ... args)
-    {
-        return std::unique_ptr<CommandLineArguments<Args...>>(new CommandLineArguments<Args...>(args...));
-    }
+          // new result object with default values of options
+        inline result_type make_result() const { return result_type(*this); }
+          // result collecting statistics: spec.make_result<CollectStatistics>()
+        template <typename Policy> inline basic_result_type<Policy> make_result() const { return basic_result_type<Policy>(*this); }
 
-// ----------------------------------------------------------------------
+          // Does not allocate for a valid command line: argv is permuted
+          // (like GNU getopt does) so that positional arguments follow
+          // argv[0] in their original order, aResult.args() is a view of
+          // them. On error the tokens read so far are permuted the same way
+          // (the rest of argv is not moved). Threads parsing the same argv
+          // concurrently must use the streaming parse() below, which does
+          // not modify argv. aResult is
+          // reset to default values before parsing, it can be reused for
+          // many parses.
+          // Throws CommandLineError on error, prints help and exits if help
+          // was requested, see try_parse() for reporting errors without
+          // exceptions.
+        template <typename Policy> void parse(int argc, const char *argv[], basic_result_type<Policy>& aResult) const
+            {
+                check(try_parse(argc, argv, aResult), aResult);
+            }
 
-} // namespace command_line_arguments
+          // Streaming parse: aOnArg(std::string_view) is called for each
+          // positional argument as soon as it is found, arguments are not
+          // stored and aResult.args() is empty. The maximum number of
+          // arguments is checked before each call, the minimum at the end.
+          // Pages of response files are released from memory as parsing
+          // proceeds. Views passed to aOnArg stay valid until the next
+          // parse, except arguments of response files with quotes or
+          // escapes: their unquoted copy is released when aOnArg returns
+          // (not for ArgBatches, which keeps the views).
+        template <typename Policy, typename OnArg> void parse(int argc, const char *argv[], basic_result_type<Policy>& aResult, OnArg&& aOnArg) const
+            {
+                check(try_parse(argc, argv, aResult, std::forward<OnArg>(aOnArg)), aResult);
+            }
+
+          // Parses a command line string split like a POSIX shell does:
+          // at white space, with '...', "..." and \ quoting, no expansions.
+          // The first token is the program name. Values and arguments are
+          // views of aLine (or of aResult for tokens with quotes), aLine
+          // must outlive aResult.
+        template <typename Policy> void parse(std::string_view aLine, basic_result_type<Policy>& aResult) const
+            {
+                check(try_parse(aLine, aResult), aResult);
+            }
+
+          // The same as parse() but neither throws nor exits, errors
+          // (including help request) are returned:
+          //   if (const auto status = spec.try_parse(argc, argv, result); !status)
+          //       std::cerr << status.error().message() << '\n';
+        template <typename Policy> ParseStatus try_parse(int argc, const char *argv[], basic_result_type<Policy>& aResult) const
+            {
+                typename basic_result_type<Policy>::StoreArg store_arg(aResult);
+                const ParseStatus status = try_parse(argc, argv, aResult, store_arg);
+                store_arg.finish(); // on error too: argv is left permuted as documented
+                if (status)
+                    aResult.make_args();
+                return status;
+            }
+
+        template <typename Policy, typename OnArg> ParseStatus try_parse(int argc, const char *argv[], basic_result_type<Policy>& aResult, OnArg&& aOnArg) const
+            {
+                ArgvTokens source{argv, argc, 0};
+                if constexpr (std::is_same<std::decay_t<OnArg>, typename basic_result_type<Policy>::StoreArg>::value)
+                    return parse_tokens(source, aResult, aOnArg);
+                else
+                    return parse_tokens(source, aResult, _StreamArg<std::remove_reference_t<OnArg>>{aOnArg});
+            }
+
+        template <typename Policy> ParseStatus try_parse(std::string_view aLine, basic_result_type<Policy>& aResult) const
+            {
+                ResponseFileTokenizer source(aLine, ResponseFiles::quoted, aResult.unquoted());
+                typename basic_result_type<Policy>::StoreArg store_arg(aResult);
+                const ParseStatus status = parse_tokens(source, aResult, store_arg);
+                if (status)
+                    aResult.make_args();
+                return status;
+            }
+
+          // Subcommands (git style): global options (of this
+          // specification) up to the first positional argument, which is
+          // the name of one of aCommands, the rest of argv is parsed by the
+          // specification made by that subcommand (other subcommands are
+          // not made) and aOnCommand(std::string_view name, const auto&
+          // result) is called. Token numbers of errors refer to argv.
+        template <typename Policy, class ... Commands, typename OnCommand> ParseStatus try_parse(int argc, const char *argv[], basic_result_type<Policy>& aResult, const Subcommands<Commands...>& aCommands, OnCommand&& aOnCommand) const
+            {
+                return parse_subcommand<false>(argc, argv, aResult, aCommands, aOnCommand);
+            }
+
+          // The same, throws CommandLineError on error, prints help and
+          // exits if requested, global help lists the subcommands.
+        template <typename Policy, class ... Commands, typename OnCommand> void parse(int argc, const char *argv[], basic_result_type<Policy>& aResult, const Subcommands<Commands...>& aCommands, OnCommand&& aOnCommand) const
+            {
+                const ParseStatus status = parse_subcommand<true>(argc, argv, aResult, aCommands, aOnCommand);
+                if (!status && status.error().code() == ParseErrorCode::help_requested) {
+                    print_help(std::cerr, aResult.program_name(), status.error());
+                    aCommands.print_help(std::cerr);
+                    exit(1);
+                }
+                check(status, aResult);
+            }
+
+          // Parses tokens from aSource (ArgvTokens, ResponseFileTokenizer,
+          // anything with bool next(std::string_view&)), the first token is
+          // the program name. aOnArg(aSource, std::string_view) is called
+          // for each positional argument, if it returns bool, false stops
+          // parsing (the rest of aSource is not read) and that argument is
+          // not counted by min_max().
+        template <typename Source, typename Policy, typename OnArg> ParseStatus parse_tokens(Source& aSource, basic_result_type<Policy>& aResult, OnArg&& aOnArg) const
+            {
+                if constexpr (Policy::enabled) {
+                    const auto start = std::chrono::steady_clock::now();
+                    const ParseStatus status = parse_tokens_helper(aSource, aResult, aOnArg);
+                    aResult.mStatistics.parsed(status, aResult.mTokenNo, aResult.mUnquoted ? &*aResult.mUnquoted : nullptr, std::chrono::steady_clock::now() - start);
+                    return status;
+                }
+                else
+                    return parse_tokens_helper(aSource, aResult, aOnArg);
+            }
+
+          // help with the usage of the Arg<PrintHelp> option that caused ParseErrorCode::help_requested
+        inline void print_help(std::ostream& out, std::string_view aProgramName, const ParseError& aHelpRequest) const
+            {
+                print_help(out, aProgramName, help_at(aHelpRequest.option()));
+            }
+
+        inline void print_help(std::ostream& out, std::string_view aProgramName, const PrintHelp* aHelp = nullptr) const
+            {
+                const PrintHelp default_help;
+                if (aHelp == nullptr)
+                    aHelp = default_value<PrintHelp>("help");
+                if (aHelp == nullptr)
+                    aHelp = &default_help;
+                out << aHelp->message(aProgramName) << std::endl << "Options:" << std::endl;
+                help_helper(out);
+            }
+
+          // Calls aOnName(std::string_view) for each long name (without
+          // --) starting with aPrefix, in sorted order, returns the number
+          // of names. Only the name tables of the specification are read.
+        template <typename OnName> std::size_t complete(std::string_view aPrefix, OnName&& aOnName) const
+            {
+                const auto [first, last] = long_names_starting_with(aPrefix);
+                for (const index_t* index = first; index != last; ++index)
+                    aOnName(mLongNames[*index]);
+                return static_cast<std::size_t>(last - first);
+            }
+
+          // Completion query mode for shell integration: if argv[1] is
+          // aOption, writes "--name" lines of long options matching the
+          // word being completed (argv[2]: "", "-" or "--prefix") to out
+          // and returns true. Nothing else is parsed, no result is needed:
+          //   if (spec.complete(argc, argv, std::cout)) return 0;
+        bool complete(int argc, const char *argv[], std::ostream& out, std::string_view aOption = "--complete") const
+            {
+                if (argc < 2 || argv[1] != aOption)
+                    return false;
+                std::string_view word = argc > 2 ? argv[2] : "";
+                if (word == "-")
+                    word = std::string_view();
+                else if (word.substr(0, 2) == "--" && word.find('=') == std::string_view::npos)
+                    word.remove_prefix(2);
+                else if (!word.empty())
+                    return true; // a positional argument, a short option or a value
+                complete(word, [&out](std::string_view aName) { out << "--" << aName << '\n'; });
+                return true;
+            }
+
+          // Handles of all options in the order of declaration, to be
+          // used with structured bindings:
+          //   auto [h_output, h_verbose] = cl->handles();
+          //   cl->get(h_verbose);
+        static constexpr auto handles() { return handles_helper(std::index_sequence_for<Args...>{}); }
+
+     private:
+        using index_t = std::uint16_t;
+        static_assert(sizeof...(Args) < std::numeric_limits<index_t>::max(), "too many options");
+        static constexpr std::size_t npos = std::size_t(-1);
+        static constexpr std::size_t ambiguous = npos - 1; // find_abbreviation() result
+
+        template <typename Source, typename Result, typename OnArg> ParseStatus parse_tokens_helper(Source& aSource, Result& aResult, OnArg& aOnArg) const
+            {
+                if constexpr (std::is_same<Source, ArgvTokens>::value)
+                    aResult.reset(aSource.argv);
+                else
+                    aResult.reset(nullptr);
+                if (aSource.next(aResult.mProgramName))
+                    ++aResult.mTokenNo;
+                else if (const std::string_view rest = _unterminated(aSource); !rest.empty())
+                    return ParseError(ParseErrorCode::unterminated_quote, 0, ParseError::npos, rest);
+                aResult.mReleaseResponseFiles = !std::is_same<std::decay_t<OnArg>, typename Result::StoreArg>::value;
+                if (const ParseStatus status = process_tokens(aSource, aOnArg, aResult, 0); !status)
+                    return status;
+                if (aResult.mArgsFound < mMinArgs)
+                    return ParseError(ParseErrorCode::too_few_arguments, aResult.mTokenNo, ParseError::npos, std::string_view());
+                return {};
+            }
+
+          // open addressing table of long option names, at most half full, slots keep option index + 1
+        static constexpr std::size_t long_table_size()
+            {
+                std::size_t size = 2;
+                while (size < sizeof...(Args) * 2)
+                    size *= 2;
+                return size;
+            }
+
+        static constexpr int max_response_file_depth = 16;
+
+        std::size_t mMinArgs, mMaxArgs;
+        ResponseFiles mResponseFiles = ResponseFiles::off;
+        Conversion mConversion = Conversion::eager;
+        bool mAbbreviations = true;
+        index_t mLongTable[long_table_size()] = {};
+        index_t mShortTable[256] = {}; // indexed by unsigned char, keeps option index + 1
+        std::string_view mLongNames[sizeof...(Args) + 1] = {}; // probed by find_long()
+        index_t mSortedLong[sizeof...(Args) + 1] = {}; // indexes of options with long names sorted by name, for abbreviations and completion
+        std::size_t mLongCount = 0;                     // options with long names
+
+        template <typename Policy, class ... A> friend class BasicParseResult;
+        friend class BatchResult<Args...>;
+        friend class ParseStatistics<Args...>;
+
+          // legacy error reporting of parse()
+        template <typename Result> void check(const ParseStatus& aStatus, const Result& aResult) const
+            {
+                if (aStatus)
+                    return;
+                if (aStatus.error().code() == ParseErrorCode::help_requested) {
+                    print_help(std::cerr, aResult.program_name(), aStatus.error());
+                    exit(1);
+                }
+                _raise(CommandLineError(aStatus.error().message()));
+            }
+
+        template <typename Source, typename OnArg, typename Result> ParseStatus process_tokens(Source& aSource, OnArg& aOnArg, Result& aResult, int aDepth) const
+            {
+                auto next = [&aSource, &aResult](std::string_view& aToken) {
+                    if (!aSource.next(aToken))
+                        return false;
+                    ++aResult.mTokenNo;
+                    return true;
+                };
+                auto error = [&aResult](ParseErrorCode aCode, std::size_t aOption, std::string_view aText, const char* aDetail = nullptr) {
+                    return ParseError(aCode, aResult.mTokenNo - 1, aOption, aText, aDetail);
+                };
+                std::string_view token;
+                while (next(token)) {
+                    if (token.size() > 1 && token[0] == '-') { // single - is not an option, it is stdin or stdout
+                        if (token[1] == '-') {
+                              // support for long option and its value separated by =
+                            const std::string_view name_value = token.substr(2);
+                            const std::size_t eq_sign = name_value.find('=');
+                            const std::string_view name = name_value.substr(0, eq_sign);
+                            std::size_t index = find_long(name.data(), name.data() + name.size());
+                            if (index == npos && mAbbreviations && !name.empty()) {
+                                index = find_abbreviation(name);
+                                if (index == ambiguous)
+                                    return error(ParseErrorCode::ambiguous_long_option, npos, token);
+                            }
+                            if (index == npos)
+                                return error(ParseErrorCode::unrecognized_long_option, npos, token);
+                            std::string_view option_value;
+                            if (eq_sign != std::string_view::npos)
+                                option_value = name_value.substr(eq_sign + 1);
+                            else if (takes_value(index) && !next(option_value))
+                                return _unterminated(aSource).empty() ? error(ParseErrorCode::missing_value, index, token) : ParseError(ParseErrorCode::unterminated_quote, aResult.mTokenNo, npos, _unterminated(aSource));
+                            if (const ParseErrorCode code = consume_at(index, option_value, aResult); code != ParseErrorCode::none)
+                                return error(code, index, (code == ParseErrorCode::invalid_value || code == ParseErrorCode::value_out_of_range) ? option_value : token, type_name(index));
+                        }
+                        else {
+                            for (std::size_t pos = 1; pos < token.size(); ++pos) {
+                                const std::size_t index = index_of(token[pos]);
+                                if (index == npos)
+                                    return error(ParseErrorCode::unrecognized_short_option, npos, token.substr(pos, 1));
+                                std::string_view option_value;
+                                if (takes_value(index)) {
+                                    option_value = token.substr(pos + 1);
+                                    if (option_value.empty() && !next(option_value))
+                                        return _unterminated(aSource).empty() ? error(ParseErrorCode::missing_value, index, token.substr(pos, 1)) : ParseError(ParseErrorCode::unterminated_quote, aResult.mTokenNo, npos, _unterminated(aSource));
+                                    pos = token.size();
+                                }
+                                if (const ParseErrorCode code = consume_at(index, option_value, aResult); code != ParseErrorCode::none)
+                                    return error(code, index, (code == ParseErrorCode::invalid_value || code == ParseErrorCode::value_out_of_range) ? option_value : token, type_name(index));
+                            }
+                        }
+                    }
+                    else if (token.size() > 1 && token[0] == '@' && mResponseFiles != ResponseFiles::off) {
+                        if (const ParseStatus status = expand_response_file(token.substr(1), aOnArg, aResult, aDepth); !status)
+                            return status;
+                    }
+                    else if constexpr (std::is_same<decltype(aOnArg(aSource, token)), bool>::value) {
+                          // the token stopping the parse is not counted
+                        if (!aOnArg(aSource, token))
+                            return {};
+                        if (++aResult.mArgsFound > mMaxArgs)
+                            return error(ParseErrorCode::too_many_arguments, npos, token);
+                    }
+                    else {
+                        if (++aResult.mArgsFound > mMaxArgs)
+                            return error(ParseErrorCode::too_many_arguments, npos, token);
+                        aOnArg(aSource, token);
+                        if constexpr (std::is_same<Source, ResponseFileTokenizer>::value && _drops_unquoted<OnArg>::value)
+                            aSource.drop_unquoted(token);
+                    }
+                }
+                if (const std::string_view rest = _unterminated(aSource); !rest.empty())
+                    return ParseError(ParseErrorCode::unterminated_quote, aResult.mTokenNo, npos, rest);
+                return {};
+            }
+
+          // global options are parsed until the first positional argument
+          // (stop), which must be in argv, the rest is dispatched
+        template <bool Check, typename Result, typename Commands, typename OnCommand> ParseStatus parse_subcommand(int argc, const char *argv[], Result& aResult, const Commands& aCommands, OnCommand& aOnCommand) const
+            {
+                int command_no = 0;
+                bool in_response_file = false;
+                std::string_view command; // a view of argv or of aResult (response file)
+                auto stop = [&command_no, &in_response_file, &command](auto& aSource, std::string_view aArg) {
+                    if constexpr (std::is_same<std::decay_t<decltype(aSource)>, ArgvTokens>::value)
+                        command_no = aSource.next_no - 1;
+                    else
+                        in_response_file = true;
+                    command = aArg;
+                    return false;
+                };
+                ArgvTokens source{argv, argc, 0};
+                if (const ParseStatus status = parse_tokens(source, aResult, stop); !status)
+                    return status;
+                if (in_response_file)
+                    return ParseError(ParseErrorCode::subcommand_in_response_file, aResult.mTokenNo - 1, npos, command);
+                if (command_no == 0)
+                    return ParseError(ParseErrorCode::missing_subcommand, aResult.mTokenNo, npos, std::string_view());
+                return aCommands.template dispatch<Check>(argc - command_no, argv + command_no, static_cast<std::size_t>(command_no), aOnCommand);
+            }
+
+        template <typename OnArg, typename Result> ParseStatus expand_response_file(std::string_view aFilename, OnArg& aOnArg, Result& aResult, int aDepth) const
+            {
+                if (aDepth >= max_response_file_depth)
+                    return ParseError(ParseErrorCode::response_files_nested_too_deeply, aResult.mTokenNo - 1, npos, aFilename);
+                MappedFile& file = aResult.response_file_data().emplace_back(std::string(aFilename));
+                if (file.failed() != nullptr)
+                    return ParseError(ParseErrorCode::response_file_unreadable, aResult.mTokenNo - 1, npos, aFilename, file.failed(), file.error());
+                ResponseFileTokenizer tokenizer(file.data(), mResponseFiles, aResult.unquoted(), aResult.mReleaseResponseFiles ? &file : nullptr);
+                return process_tokens(tokenizer, aOnArg, aResult, aDepth + 1);
+            }
+
+          // constexpr: duplicate names in a constexpr specification are compile time errors
+        template <std::size_t ... Inds> constexpr void make_tables(std::index_sequence<Inds...>)
+            {
+                const std::string_view names[] = {_get<Inds>(*this).long_name() ..., std::string_view()};
+                const char short_names[] = {_get<Inds>(*this).short_name() ..., 0};
+                for (std::size_t index = 0; index < sizeof...(Args); ++index) {
+                    if (short_names[index] != 0) {
+                        index_t& entry = mShortTable[static_cast<unsigned char>(short_names[index])];
+                        if (entry != 0)
+                            _raise(CommandLineError(std::string("Duplicate short option -") + short_names[index]));
+                        entry = static_cast<index_t>(index + 1);
+                    }
+                    const std::string_view name = names[index];
+                    if (name.empty())
+                        continue;
+                    std::size_t slot = _hash_name(name.data(), name.data() + name.size());
+                    for (slot &= long_table_size() - 1; mLongTable[slot] != 0; slot = (slot + 1) & (long_table_size() - 1)) {
+                        if (names[mLongTable[slot] - 1U] == name)
+                            _raise(CommandLineError("Duplicate long option --" + std::string(name)));
+                    }
+                    mLongTable[slot] = static_cast<index_t>(index + 1);
+                    mLongNames[index] = name;
+                    mSortedLong[mLongCount++] = static_cast<index_t>(index);
+                }
+                sort_by_name(mSortedLong, mLongCount, names);
+            }
+
+          // heap sort of option indexes by aNames[index] (std::sort is not constexpr in C++17)
+        static constexpr void sort_by_name(index_t* aIndexes, std::size_t aSize, const std::string_view* aNames)
+            {
+                auto sift_down = [aIndexes, aNames](std::size_t aRoot, std::size_t aEnd) {
+                    for (std::size_t child = aRoot * 2 + 1; child < aEnd; child = aRoot * 2 + 1) {
+                        if (child + 1 < aEnd && aNames[aIndexes[child]] < aNames[aIndexes[child + 1]])
+                            ++child;
+                        if (!(aNames[aIndexes[aRoot]] < aNames[aIndexes[child]]))
+                            break;
+                        const index_t root = aIndexes[aRoot];
+                        aIndexes[aRoot] = aIndexes[child];
+                        aIndexes[child] = root;
+                        aRoot = child;
+                    }
+                };
+                for (std::size_t start = aSize / 2; start > 0; --start)
+                    sift_down(start - 1, aSize);
+                for (std::size_t end = aSize; end > 1; --end) {
+                    const index_t first = aIndexes[0];
+                    aIndexes[0] = aIndexes[end - 1];
+                    aIndexes[end - 1] = first;
+                    sift_down(0, end - 1);
+                }
+            }
+
+          // range of mSortedLong with long names starting with aPrefix, found by binary search
+        inline std::pair<const index_t*, const index_t*> long_names_starting_with(std::string_view aPrefix) const
+            {
+                const index_t* const end = mSortedLong + mLongCount;
+                const index_t* const first = std::lower_bound(static_cast<const index_t*>(mSortedLong), end, aPrefix, [this](index_t aIndex, std::string_view aName) { return mLongNames[aIndex] < aName; });
+                const index_t* const last = std::partition_point(first, end, [this, aPrefix](index_t aIndex) { return mLongNames[aIndex].substr(0, aPrefix.size()) == aPrefix; });
+                return {first, last};
+            }
+
+          // index of the only option with the long name starting with aPrefix, npos if none, ambiguous if many
+        inline std::size_t find_abbreviation(std::string_view aPrefix) const
+            {
+                const auto [first, last] = long_names_starting_with(aPrefix);
+                if (first == last)
+                    return npos;
+                return last - first == 1 ? *first : ambiguous;
+            }
+
+          // returns index of the option with the long name [aFirst, aLast) or npos
+        inline std::size_t find_long(const char* aFirst, const char* aLast) const
+            {
+                const std::size_t size = static_cast<std::size_t>(aLast - aFirst);
+                for (std::size_t slot = _hash_name(aFirst, aLast) & (long_table_size() - 1); mLongTable[slot] != 0; slot = (slot + 1) & (long_table_size() - 1)) {
+                    const std::size_t index = mLongTable[slot] - 1U;
+                    const std::string_view name = mLongNames[index];
+                    if (name.size() == size && std::memcmp(name.data(), aFirst, size) == 0)
+                        return index;
+                }
+                return npos;
+            }
+
+        inline std::size_t index_of(char aName) const
+            {
+                return static_cast<std::size_t>(mShortTable[static_cast<unsigned char>(aName)]) - 1U;
+            }
+
+        inline std::size_t index_of(std::string_view aName) const
+            {
+                return find_long(aName.data(), aName.data() + aName.size());
+            }
+
+        inline static bool takes_value(std::size_t aIndex)
+            {
+                static constexpr bool takes[] = {Args::takes_value ..., false};
+                return takes[aIndex];
+            }
+
+          // Options are processed by routines instantiated once per
+          // option type, not per option, and selected by the option index
+          // from tables like this one: only the option at aIndex consumes
+          // the value.
+        template <typename Result> inline ParseErrorCode consume_at(std::size_t aIndex, std::string_view& aValue, Result& aResult) const
+            {
+                using consume_f = ParseErrorCode (*)(const Specification&, std::size_t, Result&, std::string_view&);
+                static constexpr consume_f consumers[] = {&Specification::consume_type<Result, typename Args::value_type> ..., nullptr};
+                return consumers[aIndex](*this, aIndex, aResult, aValue);
+            }
+
+        template <typename Result, typename ArgT> static ParseErrorCode consume_type(const Specification& aSelf, std::size_t aIndex, Result& aResult, std::string_view& aValue)
+            {
+                ArgT& value = aResult.mValues.template at<ArgT>(aIndex);
+                if (!aResult.mGiven[aIndex]) {
+                    aResult.mGiven[aIndex] = true;
+                    aResult.mGivenList[aResult.mGivenCount++] = static_cast<index_t>(aIndex);
+                    if constexpr (_is_list<ArgT>::value)
+                        value.clear(); // the first occurrence replaces the default
+                }
+                if constexpr (Result::policy_type::enabled)
+                    ++aResult.mStatistics.mHits[aIndex];
+                if constexpr (_takes_value<ArgT>::value && !_is_list<ArgT>::value) {
+                    if (aSelf.mConversion == Conversion::lazy) {
+                          // a repeated option replaces the pending value
+                          // unless that one cannot be converted: the
+                          // earliest error is reported, as by eager parse
+                        auto& pending = aResult.mPending[aIndex];
+                        aResult.mPendingUsed = true;
+                        if (pending.token_no != Result::converted && !std::is_same<ArgT, std::string>::value && !std::is_same<ArgT, std::string_view>::value) {
+                            ArgT scratch = value;
+                            std::string_view pending_value = pending.value;
+                            if (aSelf.template at<Arg<ArgT>>(aIndex).consume(scratch, pending_value) != ParseErrorCode::none)
+                                return ParseErrorCode::none;
+                        }
+                        pending = {aValue, aResult.mTokenNo - 1};
+                        return ParseErrorCode::none;
+                    }
+                }
+                if constexpr (Result::policy_type::enabled && _takes_value<ArgT>::value)
+                    return aResult.mStatistics.convert(aIndex, value, [&]() { return aSelf.template at<Arg<ArgT>>(aIndex).consume(value, aValue); });
+                else
+                    return aSelf.template at<Arg<ArgT>>(aIndex).consume(value, aValue);
+            }
+
+          // lazy conversion of the value recorded by consume_type()
+        template <typename Result> inline ParseStatus convert_at(std::size_t aIndex, const Result& aResult) const
+            {
+                using convert_f = ParseStatus (*)(const Specification&, std::size_t, const Result&);
+                static constexpr convert_f converters[] = {&Specification::convert_type<Result, typename Args::value_type> ..., nullptr};
+                return converters[aIndex](*this, aIndex, aResult);
+            }
+
+        template <typename Result, typename ArgT> static ParseStatus convert_type(const Specification& aSelf, std::size_t aIndex, const Result& aResult)
+            {
+                auto& pending = aResult.mPending[aIndex];
+                std::string_view value = pending.value;
+                ArgT& target = aResult.mValues.template at<ArgT>(aIndex);
+                ParseErrorCode code;
+                if constexpr (Result::policy_type::enabled)
+                    code = aResult.mStatistics.convert(aIndex, target, [&]() { return aSelf.template at<Arg<ArgT>>(aIndex).consume(target, value); });
+                else
+                    code = aSelf.template at<Arg<ArgT>>(aIndex).consume(target, value);
+                if (code != ParseErrorCode::none)
+                    return ParseError(code, pending.token_no, aIndex, value, type_name(aIndex));
+                pending.token_no = Result::converted;
+                return {};
+            }
+
+        inline static const char* type_name(std::size_t aIndex)
+            {
+                using type_name_f = const char* (*)();
+                static constexpr type_name_f names[] = {&_arg_type_name<typename _element<typename Args::value_type>::type> ..., nullptr};
+                return names[aIndex]();
+            }
+
+          // usage of Arg<PrintHelp> option at aIndex or nullptr
+        inline const PrintHelp* help_at(std::size_t aIndex) const
+            {
+                static constexpr bool is_help[] = {std::is_same<Arg<PrintHelp>, Args>::value ..., false};
+                if (aIndex >= sizeof...(Args) || !is_help[aIndex])
+                    return nullptr;
+                return &this->template at<Arg<PrintHelp>>(aIndex).default_value();
+            }
+
+          // default value of the option with aName if its type is ArgT, nullptr otherwise
+        template <typename ArgT, typename NameT> const ArgT* default_value(NameT aName) const
+            {
+                const std::size_t index = index_of(aName);
+                static constexpr bool same_type[] = {std::is_same<Arg<ArgT>, Args>::value ..., false};
+                if (index == npos || !same_type[index])
+                    return nullptr;
+                return &this->template at<Arg<ArgT>>(index).default_value();
+            }
+
+        template <std::size_t ... Inds> static constexpr auto handles_helper(std::index_sequence<Inds...>)
+            {
+                return Tuple<Handle<Inds> ...>(Handle<Inds>{} ...);
+            }
+
+        inline void help_helper(std::ostream& out) const
+            {
+                using help_f = std::string (*)(const Specification&, std::size_t);
+                static constexpr help_f helps[] = {&Specification::help_type<typename Args::value_type> ..., nullptr};
+                for (std::size_t index = 0; index < sizeof...(Args); ++index)
+                    out << "  " << helps[index](*this, index) << std::endl;
+            }
+
+        template <typename ArgT> static std::string help_type(const Specification& aSelf, std::size_t aIndex)
+            {
+                return aSelf.template at<Arg<ArgT>>(aIndex).help();
+            }
+
+          // --long-name or -s of the option at aIndex
+        inline std::string name_at(std::size_t aIndex) const
+            {
+                using name_f = std::string (*)(const Specification&, std::size_t);
+                static constexpr name_f names[] = {&Specification::name_type<typename Args::value_type> ..., nullptr};
+                return names[aIndex](*this, aIndex);
+            }
+
+        template <typename ArgT> static std::string name_type(const Specification& aSelf, std::size_t aIndex)
+            {
+                return aSelf.template at<Arg<ArgT>>(aIndex).name_s();
+            }
+
+    };
+
+      // Specification of options of literal types (numbers, bool,
+      // std::string_view, Count, PrintHelp) can be built at compile time
+      // and placed in read-only data, nothing is done on startup:
+      //   constexpr auto spec = make_specification(Arg<int>('n', "count", 1, Help("count")), ...).min_max(1, 2);
+    template <class ... Args> constexpr Specification<Args...> make_specification(const Args& ... args)
+    {
+        return Specification<Args...>(args...);
+    }
+
+// ----------------------------------------------------------------------
+
+    inline const char* _error_code_name(ParseErrorCode aCode)
+    {
+        switch (aCode) {
+          case ParseErrorCode::none: return "none";
+          case ParseErrorCode::help_requested: return "help_requested";
+          case ParseErrorCode::unrecognized_long_option: return "unrecognized_long_option";
+          case ParseErrorCode::unrecognized_short_option: return "unrecognized_short_option";
+          case ParseErrorCode::ambiguous_long_option: return "ambiguous_long_option";
+          case ParseErrorCode::missing_value: return "missing_value";
+          case ParseErrorCode::invalid_value: return "invalid_value";
+          case ParseErrorCode::value_out_of_range: return "value_out_of_range";
+          case ParseErrorCode::too_many_arguments: return "too_many_arguments";
+          case ParseErrorCode::too_few_arguments: return "too_few_arguments";
+          case ParseErrorCode::unterminated_quote: return "unterminated_quote";
+          case ParseErrorCode::response_file_unreadable: return "response_file_unreadable";
+          case ParseErrorCode::response_files_nested_too_deeply: return "response_files_nested_too_deeply";
+          case ParseErrorCode::missing_subcommand: return "missing_subcommand";
+          case ParseErrorCode::unknown_subcommand: return "unknown_subcommand";
+          case ParseErrorCode::subcommand_in_response_file: return "subcommand_in_response_file";
+        }
+        return "";
+    }
+
+    inline void _write_json_string(std::ostream& out, std::string_view aText)
+    {
+        out << '"';
+        for (char c: aText) {
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20)
+                out << "\\u00" << "0123456789abcdef"[(c >> 4) & 0xF] << "0123456789abcdef"[c & 0xF];
+            else
+                out << c;
+        }
+        out << '"';
+    }
+
+      // statistics of results with the NoStatistics policy
+    struct _NoStatistics
+    {
+        template <typename Spec> explicit constexpr _NoStatistics(const Spec&) {}
+    };
+
+      // Counters of the parses into a result with the CollectStatistics
+      // policy, they accumulate until clear(). They are updated without
+      // locking: parse into one result per thread and merge() the
+      // statistics to aggregate. Nothing is allocated during parse.
+    template <class ... Args> class ParseStatistics
+    {
+     public:
+        using specification_type = Specification<Args...>;
+
+        explicit inline ParseStatistics(const specification_type& aSpecification) : mSpecification(&aSpecification) {}
+
+        inline std::size_t parses() const { return mParses; }
+        inline std::size_t failed() const { return mFailed; }
+          // tokens read, including program names and tokens of response files
+        inline std::size_t tokens() const { return mTokens; }
+        inline std::chrono::nanoseconds parse_time() const { return mParseTime; }
+          // Heap allocations of the result storage: growth of the
+          // positional argument list (collected when response files are
+          // used), of std::string and list values, unquoted tokens not
+          // fitting into std::string. Allocations of callbacks and of
+          // opening response files are not counted.
+        inline std::size_t allocations() const { return mAllocations; }
+          // number of times the option at aIndex (order of declaration) was found
+        inline std::size_t hits(std::size_t aIndex) const { return mHits[aIndex]; }
+        template <std::size_t Ind> inline std::size_t hits(Handle<Ind>) const { return mHits[Ind]; }
+          // values of the option converted and time spent converting, in
+          // Conversion::lazy mode conversions done by get() are counted
+        inline std::size_t conversions(std::size_t aIndex) const { return mConversions[aIndex]; }
+        inline std::chrono::nanoseconds conversion_time(std::size_t aIndex) const { return mConversionTime[aIndex]; }
+          // error of the first failed parse (code() is none if all
+          // succeeded) and its number (from 0), text() of the error is empty,
+          // it was a view of the parsed command line
+        inline const ParseError& first_error() const { return mFirstError; }
+        inline std::size_t first_error_parse() const { return mFirstErrorParse; }
+
+        void merge(const ParseStatistics& aOther)
+            {
+                if (mFirstError.code() == ParseErrorCode::none && aOther.mFirstError.code() != ParseErrorCode::none) {
+                    mFirstError = aOther.mFirstError;
+                    mFirstErrorParse = mParses + aOther.mFirstErrorParse;
+                }
+                mParses += aOther.mParses;
+                mFailed += aOther.mFailed;
+                mTokens += aOther.mTokens;
+                mAllocations += aOther.mAllocations;
+                mParseTime += aOther.mParseTime;
+                for (std::size_t index = 0; index < sizeof...(Args); ++index) {
+                    mHits[index] += aOther.mHits[index];
+                    mConversions[index] += aOther.mConversions[index];
+                    mConversionTime[index] += aOther.mConversionTime[index];
+                }
+            }
+
+        inline void clear() { *this = ParseStatistics(*mSpecification); }
+
+          // one line: parses=10 failed=0 tokens=40 ... hits.--output=10 ... conversion_ns.int=120 conversions.int=10
+        void print_key_value(std::ostream& out) const
+            {
+                out << "parses=" << mParses << " failed=" << mFailed << " tokens=" << mTokens << " parse_ns=" << mParseTime.count() << " allocations=" << mAllocations;
+                if (mFirstError.code() != ParseErrorCode::none) {
+                    out << " first_error=" << _error_code_name(mFirstError.code()) << " first_error_parse=" << mFirstErrorParse << " first_error_token=" << mFirstError.token_no();
+                    if (mFirstError.option() != ParseError::npos)
+                        out << " first_error_option=" << mSpecification->name_at(mFirstError.option());
+                }
+                for (std::size_t index = 0; index < sizeof...(Args); ++index)
+                    out << " hits." << mSpecification->name_at(index) << '=' << mHits[index];
+                for (const auto& type: by_type())
+                    out << " conversion_ns." << type.name << '=' << type.time.count() << " conversions." << type.name << '=' << type.conversions;
+            }
+
+        void print_json(std::ostream& out) const
+            {
+                out << "{\"parses\": " << mParses << ", \"failed\": " << mFailed << ", \"tokens\": " << mTokens << ", \"parse_ns\": " << mParseTime.count() << ", \"allocations\": " << mAllocations << ", \"first_error\": ";
+                if (mFirstError.code() != ParseErrorCode::none) {
+                    out << "{\"code\": \"" << _error_code_name(mFirstError.code()) << "\", \"parse\": " << mFirstErrorParse << ", \"token\": " << mFirstError.token_no() << ", \"option\": ";
+                    if (mFirstError.option() != ParseError::npos)
+                        _write_json_string(out, mSpecification->name_at(mFirstError.option()));
+                    else
+                        out << "null";
+                    out << '}';
+                }
+                else
+                    out << "null";
+                out << ", \"hits\": {";
+                for (std::size_t index = 0; index < sizeof...(Args); ++index) {
+                    _write_json_string(out << (index == 0 ? "" : ", "), mSpecification->name_at(index));
+                    out << ": " << mHits[index];
+                }
+                out << "}, \"conversions\": {";
+                bool first = true;
+                for (const auto& type: by_type()) {
+                    _write_json_string(out << (first ? "" : ", "), type.name);
+                    out << ": {\"count\": " << type.conversions << ", \"ns\": " << type.time.count() << '}';
+                    first = false;
+                }
+                out << "}}";
+            }
+
+     private:
+        const specification_type* mSpecification;
+        std::size_t mParses = 0;
+        std::size_t mFailed = 0;
+        std::size_t mTokens = 0;
+        std::size_t mAllocations = 0;
+        std::chrono::nanoseconds mParseTime{0};
+        ParseError mFirstError;
+        std::size_t mFirstErrorParse = 0;
+        std::size_t mHits[sizeof...(Args) + 1] = {};
+        std::size_t mConversions[sizeof...(Args) + 1] = {};
+        std::chrono::nanoseconds mConversionTime[sizeof...(Args) + 1] = {};
+
+        friend class Specification<Args...>;
+        template <typename Policy, class ... A> friend class BasicParseResult;
+
+          // called by Specification::parse_tokens() at the end of each parse
+        void parsed(const ParseStatus& aStatus, std::size_t aTokens, const std::deque<std::string>* aUnquoted, std::chrono::steady_clock::duration aTime)
+            {
+                if (!aStatus) {
+                    if (mFailed++ == 0) {
+                        const ParseError& error = aStatus.error();
+                        mFirstError = ParseError(error.code(), error.token_no(), error.option(), std::string_view(), error.detail(), error.system_error());
+                        mFirstErrorParse = mParses;
+                    }
+                }
+                ++mParses;
+                mTokens += aTokens;
+                mParseTime += std::chrono::duration_cast<std::chrono::nanoseconds>(aTime);
+                if (aUnquoted != nullptr) {
+                    for (const auto& token: *aUnquoted) {
+                        if (token.capacity() > std::string().capacity())
+                            ++mAllocations;
+                    }
+                }
+            }
+
+          // runs aConvert() storing a value into aValue of the option at aIndex
+        template <typename ArgT, typename Convert> inline ParseErrorCode convert(std::size_t aIndex, const ArgT& aValue, Convert&& aConvert)
+            {
+                constexpr bool allocates = _is_list<ArgT>::value || std::is_same<ArgT, std::string>::value;
+                std::size_t capacity = 0;
+                if constexpr (allocates)
+                    capacity = aValue.capacity();
+                const auto start = std::chrono::steady_clock::now();
+                const ParseErrorCode code = aConvert();
+                mConversionTime[aIndex] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+                ++mConversions[aIndex];
+                if constexpr (allocates) {
+                    if (aValue.capacity() != capacity)
+                        ++mAllocations;
+                }
+                return code;
+            }
+
+        struct TypeStatistics
+        {
+            const char* name;
+            std::size_t conversions;
+            std::chrono::nanoseconds time;
+        };
+
+          // conversion counters summed by option type, types without conversions are skipped
+        std::vector<TypeStatistics> by_type() const
+            {
+                static constexpr const char* (*type_names[])() = {&_arg_type_name<typename Args::value_type> ..., nullptr};
+                std::vector<TypeStatistics> types;
+                for (std::size_t index = 0; index < sizeof...(Args); ++index) {
+                    if (mConversions[index] == 0)
+                        continue;
+                    const char* name = type_names[index]();
+                    auto type = std::find_if(types.begin(), types.end(), [name](const auto& aType) { return std::strcmp(aType.name, name) == 0; });
+                    if (type == types.end())
+                        type = types.insert(types.end(), TypeStatistics{name, 0, std::chrono::nanoseconds{0}});
+                    type->conversions += mConversions[index];
+                    type->time += mConversionTime[index];
+                }
+                return types;
+            }
+    };
+
+// ----------------------------------------------------------------------
+
+      // Values of options and positional arguments produced by one parse.
+      // Refers to its Specification, which must outlive it. Policy
+      // (NoStatistics or CollectStatistics) selects instrumentation of
+      // parsing at compile time, ParseResult<Args...> is not instrumented.
+    template <typename Policy, class ... Args> class BasicParseResult
+    {
+     public:
+        using specification_type = Specification<Args...>;
+        using policy_type = Policy;
+        using statistics_type = std::conditional_t<Policy::enabled, ParseStatistics<Args...>, _NoStatistics>;
+
+        explicit inline BasicParseResult(const specification_type& aSpecification)
+            : BasicParseResult(aSpecification, std::index_sequence_for<Args...>{}) {}
+        BasicParseResult(const BasicParseResult&) = delete;
+        BasicParseResult(BasicParseResult&&) = default;
+        BasicParseResult& operator = (const BasicParseResult&) = delete;
+        BasicParseResult& operator = (BasicParseResult&&) = default;
+
+          // Access by handle is a direct tuple member access, wrong type is a compile time error
+        template <std::size_t Ind> inline const auto& get(Handle<Ind>) const
+            {
+                return value<Ind>();
+            }
+
+        template <typename ArgT, std::size_t Ind> inline const ArgT& get(Handle<Ind>) const
+            {
+                static_assert(std::is_same<ArgT, typename _tuple_element_t<Ind, Args...>::value_type>::value, "Invalid type of option requested using get()");
+                return value<Ind>();
+            }
+
+          // Access by short or long name at run time
+        template <typename ArgT, typename NameT> inline const ArgT& get(NameT aName) const
+            {
+                return get_helper<ArgT>(aName);
+            }
+
+        void report(std::ostream& out) const
+            {
+                report_helper(out, " ");
+                out << std::endl;
+                out << "ARGS (" << mArgs.size() << "):";
+                for (auto arg: mArgs)
+                    out << ' ' << arg;
+            }
+
+        inline std::string arg(std::size_t aArgNo) const
+            {
+                return std::string(mArgs[aArgNo]);
+            }
+
+        inline std::string_view arg_view(std::size_t aArgNo) const
+            {
+                return mArgs[aArgNo];
+            }
+
+        inline const Arguments& args() const { return mArgs; }
+        inline std::string_view program_name() const { return mProgramName; }
+        inline const specification_type& specification() const { return *mSpecification; }
+        inline const Tuple<typename Args::value_type ...>& values() const
+            {
+                if (const ParseStatus status = validate_all(); !status)
+                    _raise(CommandLineError(status.error().message()));
+                return mValues;
+            }
+
+          // Conversion::lazy: converts values of all options not accessed
+          // yet, returns the error for the earliest token that cannot be
+          // converted (what eager parse would have reported)
+        inline ParseStatus validate_all() const
+            {
+                ParseStatus first_error;
+                for (std::size_t index = 0; index < sizeof...(Args); ++index) {
+                    if (mPending[index].token_no != converted) {
+                        if (const ParseStatus status = mSpecification->convert_at(index, *this); !status && (first_error || status.error().token_no() < first_error.error().token_no()))
+                            first_error = status;
+                    }
+                }
+                return first_error;
+            }
+
+          // CollectStatistics policy: counters of all parses into this result
+        inline const statistics_type& statistics() const
+            {
+                static_assert(Policy::enabled, "statistics() requires a result with the CollectStatistics policy");
+                return mStatistics;
+            }
+
+        inline statistics_type& statistics()
+            {
+                static_assert(Policy::enabled, "statistics() requires a result with the CollectStatistics policy");
+                return mStatistics;
+            }
+
+     private:
+        const specification_type* mSpecification;
+        mutable Tuple<typename Args::value_type ...> mValues; // converted by get() in Conversion::lazy mode
+        std::string_view mProgramName;
+        Arguments mArgs;
+          // parsing state
+        const char** mArgv = nullptr;
+        std::size_t mArgsEnd = 1;            // argv[1, mArgsEnd) are positional arguments, set by StoreArg::finish()
+        bool mUseArgViews = false;           // response file used, positional arguments are collected in mArgViews
+        bool mReleaseResponseFiles = false;  // streaming parse, positional arguments are not stored
+        std::size_t mTokenNo = 0;            // tokens read so far, including the program name
+        std::size_t mArgsFound = 0;          // positional arguments found so far
+        bool mGiven[sizeof...(Args) + 1] = {}; // options found on the command line
+        typename specification_type::index_t mGivenList[sizeof...(Args) + 1] = {}; // indexes of options found, in order
+        std::size_t mGivenCount = 0;
+        bool mPendingUsed = false;           // mPending set by the last parse (Conversion::lazy)
+
+          // Conversion::lazy: value of an option found on the command line
+          // and index of its token, token_no is converted if value was
+          // converted or nothing was found
+        static constexpr std::size_t converted = std::size_t(-1);
+        struct Pending
+        {
+            std::string_view value;
+            std::size_t token_no = converted;
+        };
+        mutable Pending mPending[sizeof...(Args) + 1];
+        std::vector<std::string_view> mArgViews;
+          // created on first use, std::deque allocates when constructed
+        std::optional<std::deque<MappedFile>> mResponseFileData;
+        std::optional<std::deque<std::string>> mUnquoted;   // response file and command line string tokens with quotes and escapes removed
+        mutable statistics_type mStatistics;                // updated by get() in Conversion::lazy mode
+
+        friend class Specification<Args...>;
+        friend class BatchResult<Args...>;
+
+        template <std::size_t ... Inds> inline BasicParseResult(const specification_type& aSpecification, std::index_sequence<Inds...>)
+            : mSpecification(&aSpecification), mValues(_get<Inds>(aSpecification).default_value() ...), mStatistics(aSpecification) {}
+
+        inline void reset(const char** argv)
+            {
+                reset_values();
+                mProgramName = std::string_view();
+                mArgs = Arguments();
+                mArgv = argv;
+                mArgsEnd = 1;
+                mTokenNo = 0;
+                mArgsFound = 0;
+                mUseArgViews = false;
+                mArgViews.clear();
+                if (mResponseFileData)
+                    mResponseFileData->clear();
+                if (mUnquoted)
+                    mUnquoted->clear();
+            }
+
+        inline std::deque<MappedFile>& response_file_data()
+            {
+                if (!mResponseFileData)
+                    mResponseFileData.emplace();
+                return *mResponseFileData;
+            }
+
+        inline std::deque<std::string>& unquoted()
+            {
+                if (!mUnquoted)
+                    mUnquoted.emplace();
+                return *mUnquoted;
+            }
+
+          // only options found by the previous parse differ from defaults,
+          // the cost does not depend on the number of options
+        inline void reset_values()
+            {
+                using reset_f = void (*)(BasicParseResult&, std::size_t);
+                static constexpr reset_f resets[] = {&BasicParseResult::reset_type<typename Args::value_type> ..., nullptr};
+                for (std::size_t given_no = 0; given_no < mGivenCount; ++given_no) {
+                    const std::size_t index = mGivenList[given_no];
+                    resets[index](*this, index);
+                    mGiven[index] = false;
+                    if (mPendingUsed)
+                        mPending[index] = Pending{};
+                }
+                mGivenCount = 0;
+                mPendingUsed = false;
+            }
+
+        template <typename ArgT> static void reset_type(BasicParseResult& aSelf, std::size_t aIndex)
+            {
+                aSelf.mValues.template at<ArgT>(aIndex) = aSelf.mSpecification->template at<Arg<ArgT>>(aIndex).default_value();
+            }
+
+        inline void make_args()
+            {
+                if (mUseArgViews)
+                    mArgs = Arguments(mArgViews.data(), mArgViews.size());
+                else
+                    mArgs = Arguments(mArgv + 1, mArgsEnd - 1);
+            }
+
+          // Positional argument callback of the non-streaming parse().
+          // Tokens of argv read so far are a stack of blocks, positional
+          // arguments followed by options, each starting with a positional
+          // argument (but the first one). Adjacent blocks are merged by
+          // rotating the options of the lower one past the arguments of the
+          // upper one when the lower one is at most twice as large, as in
+          // merge sort each token is moved O(log n) times (a rotation per
+          // argument was quadratic for interleaved options and arguments).
+          // finish() merges all blocks.
+        struct StoreArg
+        {
+            struct Block
+            {
+                std::size_t start; // argv index
+                std::size_t args;  // positional arguments at start
+            };
+
+            BasicParseResult& result;
+            std::size_t depth;
+              // closed blocks at least double in size towards the bottom
+            Block blocks[sizeof(std::size_t) * 8 + 1];
+
+            explicit inline StoreArg(BasicParseResult& aResult) : result(aResult), depth(1) { blocks[0] = Block{1, 0}; }
+
+            inline void operator () (ArgvTokens& aSource, std::string_view aArg)
+                {
+                    if (result.mUseArgViews) {
+                        result.push_arg_view(aArg);
+                    }
+                    else {
+                        const std::size_t arg_no = static_cast<std::size_t>(aSource.next_no - 1);
+                        merge(arg_no, false);
+                        blocks[depth++] = Block{arg_no, 1};
+                    }
+                }
+
+              // positional arguments of argv are argv[1, mArgsEnd)
+            inline void finish()
+                {
+                    if (result.mArgv != nullptr && !result.mUseArgViews) {
+                        merge(0, true);
+                        result.mArgsEnd = 1 + blocks[0].args;
+                    }
+                }
+
+              // the top block ends at aEnd
+            inline void merge(std::size_t aEnd, bool aAll)
+                {
+                    for (; depth > 1; --depth) {
+                        Block& below = blocks[depth - 2];
+                        const Block& top = blocks[depth - 1];
+                        if (!aAll && top.start - below.start > 2 * (aEnd - top.start))
+                            break;
+                        std::rotate(result.mArgv + below.start + below.args, result.mArgv + top.start, result.mArgv + top.start + top.args);
+                        below.args += top.args;
+                    }
+                }
+
+              // argument from a response file, collect all positional arguments as views from now on
+            template <typename Source> inline void operator () (Source&, std::string_view aArg)
+                {
+                    if (!result.mUseArgViews) {
+                        if (result.mArgv != nullptr) {
+                            finish();
+                            if constexpr (Policy::enabled) {
+                                if (result.mArgViews.capacity() < result.mArgsEnd - 1)
+                                    ++result.mStatistics.mAllocations;
+                            }
+                            result.mArgViews.assign(result.mArgv + 1, result.mArgv + result.mArgsEnd);
+                        }
+                        result.mUseArgViews = true;
+                    }
+                    result.push_arg_view(aArg);
+                }
+        };
+
+        inline void push_arg_view(std::string_view aArg)
+            {
+                if constexpr (Policy::enabled) {
+                    if (mArgViews.size() == mArgViews.capacity())
+                        ++mStatistics.mAllocations;
+                }
+                mArgViews.push_back(aArg);
+            }
+
+        template <typename ArgT, typename NameT> const ArgT& get_helper(NameT aName) const
+            {
+                const std::size_t index = mSpecification->index_of(aName);
+                if (index == specification_type::npos)
+                    _raise(CommandLineError("Cannot find option " + _option_name_s(aName)));
+                static constexpr bool same_type[] = {std::is_same<Arg<ArgT>, Args>::value ..., false};
+                if (!same_type[index])
+                    _raise(CommandLineError("Invalid type of option " + _option_name_s(aName) + " requested using get(): " + typeid(ArgT).name()));
+                return value_at<ArgT>(index);
+            }
+
+          // value of the option, converted first in Conversion::lazy mode
+        template <std::size_t Ind> inline const auto& value() const
+            {
+                if (mPending[Ind].token_no != converted) {
+                    if (const ParseStatus status = specification_type::template convert_type<BasicParseResult, typename _tuple_element_t<Ind, Args...>::value_type>(*mSpecification, Ind, *this); !status)
+                        _raise(CommandLineError(status.error().message()));
+                }
+                return _get<Ind>(mValues);
+            }
+
+        template <typename ArgT> inline const ArgT& value_at(std::size_t aIndex) const
+            {
+                if (mPending[aIndex].token_no != converted) {
+                    if (const ParseStatus status = specification_type::template convert_type<BasicParseResult, ArgT>(*mSpecification, aIndex, *this); !status)
+                        _raise(CommandLineError(status.error().message()));
+                }
+                return mValues.template at<ArgT>(aIndex);
+            }
+
+        inline void report_helper(std::ostream& out, const char* aSeparator) const
+            {
+                using report_f = void (*)(const BasicParseResult&, std::size_t, std::ostream&);
+                static constexpr report_f reports[] = {&BasicParseResult::report_type<typename Args::value_type> ..., nullptr};
+                for (std::size_t index = 0; index < sizeof...(Args); ++index)
+                    reports[index](*this, index, out << (index == 0 ? "" : aSeparator));
+            }
+
+        template <typename ArgT> static void report_type(const BasicParseResult& aSelf, std::size_t aIndex, std::ostream& out)
+            {
+                aSelf.mSpecification->template at<Arg<ArgT>>(aIndex).report(out, aSelf.template value_at<ArgT>(aIndex));
+            }
+
+    };
+
+// ----------------------------------------------------------------------
+
+      // Specification together with the result of the last parse, for
+      // programs that parse their command line once. Policy selects
+      // instrumentation as for BasicParseResult.
+    template <typename Policy, class ... Args> class BasicCommandLineArguments : public Specification<Args...>
+    {
+     public:
+        using specification_type = Specification<Args...>;
+        using result_type = BasicParseResult<Policy, Args...>;
+
+        inline BasicCommandLineArguments(const Args&... a)
+            : specification_type(a...), mResult(*this) {}
+        BasicCommandLineArguments(const BasicCommandLineArguments&) = delete;
+        BasicCommandLineArguments& operator = (const BasicCommandLineArguments&) = delete;
+
+        using specification_type::parse;
+        using specification_type::print_help;
+
+        inline void parse(int argc, const char *argv[])
+            {
+                specification_type::parse(argc, argv, mResult);
+            }
+
+        template <typename OnArg, typename = std::enable_if_t<!std::is_same<std::decay_t<OnArg>, result_type>::value>> inline void parse(int argc, const char *argv[], OnArg&& aOnArg)
+            {
+                specification_type::parse(argc, argv, mResult, std::forward<OnArg>(aOnArg));
+            }
+
+        inline void parse(std::string_view aLine)
+            {
+                specification_type::parse(aLine, mResult);
+            }
+
+        using specification_type::try_parse;
+
+        inline ParseStatus try_parse(int argc, const char *argv[])
+            {
+                return specification_type::try_parse(argc, argv, mResult);
+            }
+
+        template <typename OnArg, typename = std::enable_if_t<!std::is_same<std::decay_t<OnArg>, result_type>::value>> inline ParseStatus try_parse(int argc, const char *argv[], OnArg&& aOnArg)
+            {
+                return specification_type::try_parse(argc, argv, mResult, std::forward<OnArg>(aOnArg));
+            }
+
+        inline ParseStatus try_parse(std::string_view aLine)
+            {
+                return specification_type::try_parse(aLine, mResult);
+            }
+
+          // global options into result(), then the subcommand, see Specification::parse()
+        template <class ... Commands, typename OnCommand> inline void parse(int argc, const char *argv[], const Subcommands<Commands...>& aCommands, OnCommand&& aOnCommand)
+            {
+                specification_type::parse(argc, argv, mResult, aCommands, std::forward<OnCommand>(aOnCommand));
+            }
+
+        template <class ... Commands, typename OnCommand> inline ParseStatus try_parse(int argc, const char *argv[], const Subcommands<Commands...>& aCommands, OnCommand&& aOnCommand)
+            {
+                return specification_type::try_parse(argc, argv, mResult, aCommands, std::forward<OnCommand>(aOnCommand));
+            }
+
+        inline void print_help(std::ostream& out, const PrintHelp* aHelp = nullptr) const
+            {
+                specification_type::print_help(out, mResult.program_name(), aHelp);
+            }
+
+        inline void print_help(std::ostream& out, const ParseError& aHelpRequest) const
+            {
+                specification_type::print_help(out, mResult.program_name(), aHelpRequest);
+            }
+
+        template <std::size_t Ind> inline const auto& get(Handle<Ind> aHandle) const { return mResult.get(aHandle); }
+        template <typename ArgT, std::size_t Ind> inline const ArgT& get(Handle<Ind> aHandle) const { return mResult.template get<ArgT>(aHandle); }
+        template <typename ArgT, typename NameT> inline const ArgT& get(NameT aName) const { return mResult.template get<ArgT>(aName); }
+
+        inline void report(std::ostream& out) const { mResult.report(out); }
+        inline std::string arg(std::size_t aArgNo) const { return mResult.arg(aArgNo); }
+        inline std::string_view arg_view(std::size_t aArgNo) const { return mResult.arg_view(aArgNo); }
+        inline const Arguments& args() const { return mResult.args(); }
+        inline const result_type& result() const { return mResult; }
+        inline const typename result_type::statistics_type& statistics() const { return mResult.statistics(); }
+
+     private:
+        result_type mResult;
+    };
+
+    template <class ... Args> using CommandLineArguments = BasicCommandLineArguments<NoStatistics, Args...>;
+
+      // make_command_line_arguments<CollectStatistics>(...) collects statistics of parses
+    template <typename Policy = NoStatistics, class ... Args> std::unique_ptr<BasicCommandLineArguments<Policy, Args...>> make_command_line_arguments(const Args& ... args)
+    {
+        return std::unique_ptr<BasicCommandLineArguments<Policy, Args...>>(new BasicCommandLineArguments<Policy, Args...>(args...));
+    }
+
+// ----------------------------------------------------------------------
+
+      // Subcommand of a multi-tool binary: its name, help shown in the
+      // list of subcommands and a factory (function or lambda) returning
+      // the Specification of its options (or a reference to a static
+      // one), called only if the subcommand is selected:
+      //   Subcommand("clone", Help("clone a repository"), [] { return make_specification(...).min_max(1, 2); })
+    template <typename Factory> class Subcommand
+    {
+     public:
+        constexpr Subcommand(std::string_view aName, const Help& aHelp, Factory aFactory) : mName(aName), mHelp(aHelp), mFactory(aFactory) {}
+
+        constexpr std::string_view name() const { return mName; }
+        inline decltype(auto) make() const { return mFactory(); }
+        inline std::string help() const
+            {
+                std::ostringstream out;
+                out << mName << "  -- " << mHelp;
+                return out.str();
+            }
+
+     private:
+        std::string_view mName;
+        Help mHelp;
+        Factory mFactory;
+    };
+
+      // Table of subcommands, can be constexpr, duplicate names are
+      // errors (at compile time if constexpr). Startup does nothing else,
+      // the specification of a subcommand is made when it is selected by
+      // Specification::parse(argc, argv, result, subcommands, on_command).
+    template <class ... Commands> class Subcommands : public Tuple<Commands...>
+    {
+     public:
+        static constexpr std::size_t npos = std::size_t(-1);
+
+        constexpr Subcommands(const Commands&... aCommands)
+            : Tuple<Commands...>(aCommands...), mNames{aCommands.name() ...}
+            {
+                for (std::size_t index = 0; index < sizeof...(Commands); ++index) {
+                    for (std::size_t other = 0; other < index; ++other) {
+                        if (mNames[other] == mNames[index])
+                            _raise(CommandLineError("Duplicate subcommand " + std::string(mNames[index])));
+                    }
+                }
+            }
+
+          // index of the subcommand with aName or npos
+        inline std::size_t find(std::string_view aName) const
+            {
+                for (std::size_t index = 0; index < sizeof...(Commands); ++index) {
+                    if (mNames[index] == aName)
+                        return index;
+                }
+                return npos;
+            }
+
+        inline void print_help(std::ostream& out) const
+            {
+                out << "Commands:" << std::endl;
+                help_helper(out, std::index_sequence_for<Commands...>{});
+            }
+
+     private:
+        std::string_view mNames[sizeof...(Commands) + 1];
+
+        template <class ... A> friend class Specification;
+
+          // argv[0] is the subcommand name, aOffset is its index in the argv of the global parse
+        template <bool Check, typename OnCommand> inline ParseStatus dispatch(int argc, const char *argv[], std::size_t aOffset, OnCommand& aOnCommand) const
+            {
+                const std::size_t index = find(argv[0]);
+                if (index == npos)
+                    return ParseError(ParseErrorCode::unknown_subcommand, aOffset, npos, argv[0]);
+                return dispatch_helper<Check>(index, argc, argv, aOffset, aOnCommand, std::index_sequence_for<Commands...>{});
+            }
+
+        template <bool Check, typename OnCommand, std::size_t ... Inds> inline ParseStatus dispatch_helper(std::size_t aIndex, int argc, const char *argv[], std::size_t aOffset, OnCommand& aOnCommand, std::index_sequence<Inds...>) const
+            {
+                using run_f = ParseStatus (*)(const Subcommands&, int, const char *[], std::size_t, OnCommand&);
+                static constexpr run_f runs[] = {&Subcommands::run<Inds, Check, OnCommand> ...};
+                return runs[aIndex](*this, argc, argv, aOffset, aOnCommand);
+            }
+
+          // makes the specification of the subcommand at Ind and its result, parses the rest of argv
+        template <std::size_t Ind, bool Check, typename OnCommand> static ParseStatus run(const Subcommands& aSelf, int argc, const char *argv[], std::size_t aOffset, OnCommand& aOnCommand)
+            {
+                const auto& command = _get<Ind>(aSelf);
+                auto&& specification = command.make();
+                auto result = specification.make_result();
+                if constexpr (Check) {
+                    specification.parse(argc, argv, result);
+                }
+                else if (const ParseStatus status = specification.try_parse(argc, argv, result); !status) {
+                    const ParseError& error = status.error();
+                      // text in the result (response files) does not outlive it,
+                      // argv is permuted, token_no does not index it
+                    std::string_view text = error.text();
+                    if (!text.empty() && std::none_of(argv, argv + argc, [&text](const char* arg) { return text.data() >= arg && text.data() <= arg + std::strlen(arg); }))
+                        text = std::string_view();
+                    const std::size_t token_no = error.token_no();
+                    return ParseError(error.code(), token_no + aOffset, error.option(), text, error.detail(), error.system_error());
+                }
+                aOnCommand(command.name(), static_cast<const decltype(result)&>(result));
+                return {};
+            }
+
+        template <std::size_t ... Inds> inline void help_helper(std::ostream& out, std::index_sequence<Inds...>) const
+            {
+                ((out << "  " << _get<Inds>(*this).help() << std::endl), ...);
+            }
+    };
+
+    template <class ... Commands> constexpr Subcommands<Commands...> make_subcommands(const Commands& ... aCommands)
+    {
+        return Subcommands<Commands...>(aCommands...);
+    }
+
+// ----------------------------------------------------------------------
+
+      // type of elements of BatchResult columns, bool is stored as
+      // unsigned char to keep the column contiguous and safe to fill from
+      // many threads
+    template <typename ArgT> struct _column_value { using type = ArgT; };
+    template <> struct _column_value<bool> { using type = unsigned char; };
+
+      // Results of parse_batch() stored column-wise: one contiguous
+      // std::vector per option with one element per command line (row),
+      // positional arguments of all rows in one array with row offsets.
+      // Views (positional arguments, Arg<std::string_view> values) refer
+      // to the parsed lines, which must outlive the result (response
+      // files and unquoted tokens are kept by the result). PrintHelp
+      // options have no column, a row requesting help is invalid.
+    template <class ... Args> class BatchResult
+    {
+     public:
+        using specification_type = Specification<Args...>;
+
+        explicit inline BatchResult(const specification_type& aSpecification) : mSpecification(&aSpecification) {}
+
+        inline std::size_t size() const { return mValid.size(); }
+
+          // column by handle, the type of elements is checked at compile time
+        template <std::size_t Ind> inline const auto& column(Handle<Ind>) const { return _get<Ind>(mColumns); }
+
+          // column by short or long name at run time
+        template <typename ArgT, typename NameT> inline const std::vector<typename _column_value<ArgT>::type>& column(NameT aName) const
+            {
+                return column_helper<ArgT>(aName);
+            }
+
+          // 1 if the row was parsed, 0 if it is in errors()
+        inline const std::vector<unsigned char>& valid() const { return mValid; }
+          // row number and error for rows that failed to parse, sorted by row
+        inline const std::vector<std::pair<std::size_t, ParseError>>& errors() const { return mErrors; }
+
+          // positional arguments of aRow
+        inline Arguments args(std::size_t aRow) const { return Arguments(mArgs.data() + mArgOffsets[aRow], mArgOffsets[aRow + 1] - mArgOffsets[aRow]); }
+          // positional arguments of all rows, arguments of row N are [arg_offsets()[N], arg_offsets()[N + 1])
+        inline const std::vector<std::string_view>& all_args() const { return mArgs; }
+        inline const std::vector<std::size_t>& arg_offsets() const { return mArgOffsets; }
+
+     private:
+        const specification_type* mSpecification;
+        Tuple<std::vector<typename _column_value<typename Args::value_type>::type> ...> mColumns;
+        std::vector<unsigned char> mValid;
+        std::vector<std::pair<std::size_t, ParseError>> mErrors;
+        std::vector<std::string_view> mArgs;
+        std::vector<std::size_t> mArgOffsets;
+          // deques of deques: elements (referred by mArgs and columns) never move
+        std::deque<std::deque<std::string>> mUnquoted; // tokens with quotes and escapes removed
+        std::deque<std::deque<MappedFile>> mResponseFileData;
+
+        template <class ... A, typename Lines> friend BatchResult<A...> parse_batch(const Specification<A...>&, const Lines&, std::size_t, std::size_t);
+
+          // rows of one chunk of lines, parsed by one thread
+        struct Chunk
+        {
+            std::vector<std::string_view> args;
+            std::vector<std::size_t> arg_counts;
+            std::vector<std::pair<std::size_t, ParseError>> errors;
+            std::deque<std::string> unquoted;
+            std::deque<std::deque<std::string>> response_file_unquoted;
+            std::deque<std::deque<MappedFile>> response_file_data;
+        };
+
+          // views stored from a row that used response files refer to
+          // aResult, which is reset for the next row: its response files
+          // and unquoted tokens are moved (without moving their elements)
+          // to aChunk
+        static inline void keep_response_files(Chunk& aChunk, ParseResult<Args...>& aResult)
+            {
+                if (aResult.mResponseFileData && !aResult.mResponseFileData->empty()) {
+                    aChunk.response_file_data.push_back(std::move(*aResult.mResponseFileData));
+                    aResult.mResponseFileData.reset();
+                }
+                if (aResult.mUnquoted && !aResult.mUnquoted->empty()) {
+                    aChunk.response_file_unquoted.push_back(std::move(*aResult.mUnquoted));
+                    aResult.mUnquoted.reset();
+                }
+            }
+
+        template <std::size_t ... Inds> inline void resize(std::size_t aRows, std::index_sequence<Inds...>)
+            {
+                ((is_column<Inds>() ? _get<Inds>(mColumns).resize(aRows, _get<Inds>(*mSpecification).default_value()) : void()), ...);
+                mValid.resize(aRows, 0);
+            }
+
+          // aResult is converted (parse_batch ran validate_all() in lazy mode),
+          // its values are stored without checking pending conversions again
+        template <std::size_t ... Inds> inline void store_row(std::size_t aRow, const ParseResult<Args...>& aResult, std::index_sequence<Inds...>)
+            {
+                ((is_column<Inds>() ? void(_get<Inds>(mColumns)[aRow] = _get<Inds>(aResult.mValues)) : void()), ...);
+                mValid[aRow] = 1;
+            }
+
+        template <std::size_t Ind> static constexpr bool is_column()
+            {
+                return !std::is_same<typename _tuple_element_t<Ind, Args...>::value_type, PrintHelp>::value;
+            }
+
+        template <typename ArgT, typename NameT> const std::vector<typename _column_value<ArgT>::type>& column_helper(NameT aName) const
+            {
+                const std::size_t index = mSpecification->index_of(aName);
+                if (index == specification_type::npos)
+                    _raise(CommandLineError("Cannot find option " + _option_name_s(aName)));
+                static constexpr bool same_type[] = {std::is_same<Arg<ArgT>, Args>::value ..., false};
+                if (!same_type[index])
+                    _raise(CommandLineError("Invalid type of option " + _option_name_s(aName) + " requested using column(): " + typeid(ArgT).name()));
+                return mColumns.template at<std::vector<typename _column_value<ArgT>::type>>(index);
+            }
+    };
+
+      // Parses each element of aLines (anything convertible to
+      // std::string_view) as a command line split at white space with
+      // '...', "..." and \ quoting, the first token is the program name.
+      // Lines are distributed in chunks of aChunkSize among aThreads
+      // threads (0: one per core), an idle thread takes the next
+      // unparsed chunk. Rows that fail to parse are reported in errors().
+    template <class ... Args, typename Lines> BatchResult<Args...> parse_batch(const Specification<Args...>& aSpecification, const Lines& aLines, std::size_t aThreads = 0, std::size_t aChunkSize = 1024)
+    {
+        using result_type = BatchResult<Args...>;
+        using chunk_type = typename result_type::Chunk;
+        const std::size_t rows = static_cast<std::size_t>(std::end(aLines) - std::begin(aLines));
+        result_type result(aSpecification);
+        result.resize(rows, std::index_sequence_for<Args...>{});
+        if (aChunkSize == 0)
+            aChunkSize = 1;
+        std::vector<chunk_type> chunks((rows + aChunkSize - 1) / aChunkSize);
+        if (aThreads == 0)
+            aThreads = std::max(1U, std::thread::hardware_concurrency());
+        aThreads = std::min(aThreads, chunks.size());
+
+        std::atomic<std::size_t> next_chunk{0};
+        auto worker = [&]() {
+            auto parse_result = aSpecification.make_result();
+            for (std::size_t chunk_no = next_chunk++; chunk_no < chunks.size(); chunk_no = next_chunk++) {
+                chunk_type& chunk = chunks[chunk_no];
+                const std::size_t first = chunk_no * aChunkSize, last = std::min(rows, first + aChunkSize);
+                chunk.arg_counts.resize(last - first, 0);
+                for (std::size_t row = first; row < last; ++row) {
+                    const std::size_t args_before = chunk.args.size();
+                    const std::string_view line(*(std::begin(aLines) + static_cast<std::ptrdiff_t>(row)));
+                    ResponseFileTokenizer tokens(line, ResponseFiles::quoted, chunk.unquoted);
+                    ParseStatus status = aSpecification.parse_tokens(tokens, parse_result, [&chunk](auto&, std::string_view aArg) { chunk.args.push_back(aArg); });
+                    if (status)
+                        status = parse_result.validate_all(); // Conversion::lazy
+                    if (status) {
+                        result.store_row(row, parse_result, std::index_sequence_for<Args...>{});
+                        chunk.arg_counts[row - first] = chunk.args.size() - args_before;
+                        result_type::keep_response_files(chunk, parse_result);
+                    }
+                    else {
+                        chunk.args.resize(args_before);
+                        ParseError error = status.error();
+                        if (const std::string_view text = error.text(); !text.empty() && (text.data() < line.data() || text.data() >= line.data() + line.size())) {
+                              // text is in parse_result (response file) which is reused for the next row
+                            error = ParseError(error.code(), error.token_no(), error.option(), chunk.unquoted.emplace_back(text), error.detail(), error.system_error());
+                        }
+                        chunk.errors.emplace_back(row, error);
+                    }
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (std::size_t thread_no = 1; thread_no < aThreads; ++thread_no)
+            threads.emplace_back(worker);
+        worker();
+        for (auto& thread: threads)
+            thread.join();
+
+        std::size_t total_args = 0;
+        for (const auto& chunk: chunks)
+            total_args += chunk.args.size();
+        result.mArgs.reserve(total_args);
+        result.mArgOffsets.reserve(rows + 1);
+        result.mArgOffsets.push_back(0);
+        for (auto& chunk: chunks) {
+            result.mArgs.insert(result.mArgs.end(), chunk.args.begin(), chunk.args.end());
+            for (auto count: chunk.arg_counts)
+                result.mArgOffsets.push_back(result.mArgOffsets.back() + count);
+            std::move(chunk.errors.begin(), chunk.errors.end(), std::back_inserter(result.mErrors));
+            if (!chunk.unquoted.empty())
+                result.mUnquoted.push_back(std::move(chunk.unquoted));
+            std::move(chunk.response_file_unquoted.begin(), chunk.response_file_unquoted.end(), std::back_inserter(result.mUnquoted));
+            std::move(chunk.response_file_data.begin(), chunk.response_file_data.end(), std::back_inserter(result.mResponseFileData));
+        }
+        return result;
+    }
+
+      // splits aText (e.g. MappedFile::data() of a job manifest) into lines, empty lines are skipped
+    inline std::vector<std::string_view> split_lines(std::string_view aText)
+    {
+        std::vector<std::string_view> lines;
+        for (std::size_t start = 0; start < aText.size(); ) {
+            std::size_t end = aText.find('\n', start);
+            if (end == std::string_view::npos)
+                end = aText.size();
+            if (end > start)
+                lines.push_back(aText.substr(start, end - start));
+            start = end + 1;
+        }
+        return lines;
+    }
+
+// ----------------------------------------------------------------------
+
+} // namespace command_line_arguments
+
+  // structured bindings of Tuple (e.g. handles())
+namespace std
+{
+    template <typename ... Ts> struct tuple_size<command_line_arguments::Tuple<Ts...>> : public std::integral_constant<std::size_t, sizeof...(Ts)> {};
+    template <std::size_t Ind, typename ... Ts> struct tuple_element<Ind, command_line_arguments::Tuple<Ts...>> { using type = command_line_arguments::_tuple_element_t<Ind, Ts...>; };
+}
 
 // ----------------------------------------------------------------------
@@ -0,0 +1,24 @@
+#include <cstdlib>
+#include <new>
+
+// ----------------------------------------------------------------------
+
+  // Counting allocator, parse() of a valid command line must not
+  // allocate. Counts allocations of the calling thread, tests parsing in
+  // many threads do not race on it. Separate translation unit: if inlined
+  // into the tests, gcc with optimization reports free() of the result of
+  // operator new as a mismatch.
+thread_local std::size_t sAllocations = 0;
+
+void* operator new(std::size_t aSize)
+{
+    ++sAllocations;
+    if (void* p = std::malloc(aSize == 0 ? 1 : aSize))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* aPtr) noexcept { std::free(aPtr); }
+void operator delete(void* aPtr, std::size_t) noexcept { std::free(aPtr); }
+
+// ----------------------------------------------------------------------
@@ -0,0 +1,53 @@
+// Built with -fno-exceptions: try_parse() reports errors without throwing
+
+#include <cstdio>
+
+#include "command-line-arguments.hh"
+
+// ----------------------------------------------------------------------
+
+static int failed(const char* aMessage)
+{
+    std::fprintf(stderr, "test FAILED: %s\n", aMessage);
+    return 1;
+}
+
+// ----------------------------------------------------------------------
+
+int main()
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+    using command_line_arguments::PrintHelp;
+    using command_line_arguments::ParseErrorCode;
+
+    const auto spec = command_line_arguments::make_specification(
+        Arg<std::string>('o', "output", "-", Help()),
+        Arg<int>('n', "number", 0, Help()),
+        Arg<Count>('v', "verbose", Count(), Help()),
+        Arg<PrintHelp>('h', "help", "Usage: {progname} <file>", Help())
+                                                                 );
+    const auto [h_output, h_number, h_verbose, h_help] = spec.handles();
+    auto result = spec.make_result();
+
+    const char* valid[] = {"prog", "-vv", "--output", "out", "-n", "42", "file"};
+    if (!spec.try_parse(7, valid, result) || result.get(h_output) != "out" || result.get(h_number) != 42 || static_cast<std::size_t>(result.get(h_verbose)) != 2 || result.args().size() != 1)
+        return failed("try_parse of a valid command line");
+
+    const char* invalid[] = {"prog", "-n", "4x2"};
+    if (const auto status = spec.try_parse(3, invalid, result); status || status.error().code() != ParseErrorCode::invalid_value || status.error().token_no() != 2
+        || status.error().option() != h_number.index || status.error().message() != "Cannot parse \"4x2\" as int")
+        return failed("try_parse of an invalid value");
+
+    if (const auto status = spec.try_parse("prog -v --help", result); status || status.error().code() != ParseErrorCode::help_requested || status.error().option() != h_help.index)
+        return failed("try_parse of help request");
+
+    const std::vector<std::string> lines{"prog -n 1", "prog -n x", "prog --unknown"};
+    const auto batch = command_line_arguments::parse_batch(spec, lines, 2, 1);
+    if (batch.errors().size() != 2 || batch.errors()[0].second.code() != ParseErrorCode::invalid_value || batch.errors()[1].second.code() != ParseErrorCode::unrecognized_long_option)
+        return failed("parse_batch errors");
+    return 0;
+}
+
+// ----------------------------------------------------------------------
@@ -1,9 +1,38 @@
+#include <cstdlib>
+#include <new>
+#include <fstream>
+#include <cstdio>
+#include <thread>
+#include <random>
+#include <clocale>
+
 #include "command-line-arguments.hh"
 
 // ----------------------------------------------------------------------
 
 void regression_test();
 void test(int argc, const char** argv, const char* expected_report);
+void test_no_allocations();
+void test_handles();
+void test_response_files();
+void test_streaming();
+void test_concurrent_parse();
+void test_batch();
+void test_parse_line();
+void test_shell_conformance();
+void test_try_parse();
+void test_numeric_conversion();
+void test_list_options();
+void test_lazy_conversion();
+void test_constexpr_specification();
+void test_statistics();
+void test_abbreviations();
+void test_subcommands();
+
+// ----------------------------------------------------------------------
+
+  // allocations of the calling thread, counted by operator new in test-allocations.cc
+extern thread_local std::size_t sAllocations;
 
 // ----------------------------------------------------------------------
 
@@ -52,6 +81,44 @@ void regression_test()
     test(std::end(argv1) - std::begin(argv1), argv1, "aa= bb=cc ee= g=hh int=0 ii=666 dd=0.333333 true=0 false=1 help=\nARGS (0):");
     const char* argv2[] = {"progname", "--true", "--aa", "aaaa", "argument1", "--dd=11.11", "argument2", "-g", "ggggg gggg"};
     test(std::end(argv2) - std::begin(argv2), argv2, "aa=aaaa bb=cc ee= g=ggggg gggg int=0 ii=666 dd=11.11 true=1 false=1 help=\nARGS (2): argument1 argument2");
+    const char* argv3[] = {"progname", "--int", "7", "--ii=5", "--false", "--bb", "--ee", "-"};
+    test(std::end(argv3) - std::begin(argv3), argv3, "aa= bb=--ee ee= g=hh int=7 ii=5 dd=0.333333 true=0 false=0 help=\nARGS (1): -");
+    const char* argv4[] = {"progname", "-tfi", "12", "-fgx", "-e", "eee"};
+    test(std::end(argv4) - std::begin(argv4), argv4, "aa= bb=cc ee=eee g=x int=12 ii=666 dd=0.333333 true=1 false=1 help=\nARGS (0):");
+
+    try {
+        using command_line_arguments::Arg;
+        using command_line_arguments::Help;
+        make_command_line_arguments(Arg<int>("dup", 0, Help()), Arg<bool>("dup", false, Help()));
+        throw std::runtime_error("test FAILED: duplicate long option accepted");
+    }
+    catch (command_line_arguments::CommandLineError&) {
+    }
+    try {
+        using command_line_arguments::Arg;
+        using command_line_arguments::Help;
+        make_command_line_arguments(Arg<int>('d', 0, Help()), Arg<bool>('d', "dup", false, Help()));
+        throw std::runtime_error("test FAILED: duplicate short option accepted");
+    }
+    catch (command_line_arguments::CommandLineError&) {
+    }
+
+    test_no_allocations();
+    test_handles();
+    test_response_files();
+    test_streaming();
+    test_concurrent_parse();
+    test_batch();
+    test_parse_line();
+    test_shell_conformance();
+    test_try_parse();
+    test_numeric_conversion();
+    test_list_options();
+    test_lazy_conversion();
+    test_constexpr_specification();
+    test_statistics();
+    test_abbreviations();
+    test_subcommands();
 }
 
 // ----------------------------------------------------------------------
@@ -87,3 +154,940 @@ void test(int argc, const char** argv, const char* expected_report)
 }
 
 // ----------------------------------------------------------------------
+
+void test_no_allocations()
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+
+    auto cl = make_command_line_arguments(
+        Arg<std::string_view>('o', "output", "-", Help()),
+        Arg<std::string_view>("a-rather-long-option-name", "", Help()),
+        Arg<long>('n', "number", 0L, Help()),
+        Arg<double>("ratio", 1.0, Help()),
+        Arg<bool>('q', "quiet", false, Help()),
+        Arg<Count>('v', "verbose", Count(), Help())
+                                          );
+    const char* argv[] = {"progname", "first-positional-argument-longer-than-sso", "-vvqn", "42", "--a-rather-long-option-name=value-longer-than-sso",
+                          "second", "--ratio", "0.5", "-ooutput-file-name-longer-than-sso", "--number=-7", "third"};
+    sAllocations = 0;
+    cl->parse(std::end(argv) - std::begin(argv), argv);
+    const std::size_t allocations = sAllocations;
+    if (allocations != 0)
+        throw std::runtime_error("test FAILED: parse() allocated " + std::to_string(allocations) + " times");
+    const auto& args = cl->args();
+    if (args.size() != 3 || args[0] != "first-positional-argument-longer-than-sso" || cl->arg_view(1) != "second" || args[2] != "third")
+        throw std::runtime_error("test FAILED: positional arguments are not preserved by parse()");
+    if (std::string(argv[4]) != "-vvqn" || std::string(argv[5]) != "42" || std::string(argv[10]) != "--number=-7")
+        throw std::runtime_error("test FAILED: options order is not preserved by parse()");
+    if (cl->get<std::string_view>('o') != "output-file-name-longer-than-sso" || cl->get<long>('n') != -7 || int(cl->get<Count>('v')) != 2)
+        throw std::runtime_error("test FAILED: unexpected option values after parse()");
+
+      // interleaved with gaps of different sizes: positional arguments in their order, then options in theirs
+    std::vector<std::string> tokens{"progname"}, options;
+    for (std::size_t no = 0; no < 1000; ++no) {
+        tokens.push_back("arg" + std::to_string(no));
+        for (std::size_t option_no = 0; option_no < no % 4; ++option_no)
+            tokens.push_back("-q");
+        if (no % 7 == 0) {
+            tokens.push_back("-n");
+            tokens.push_back(std::to_string(no));
+        }
+    }
+    std::copy_if(tokens.begin() + 1, tokens.end(), std::back_inserter(options), [](const std::string& aToken) { return aToken.compare(0, 3, "arg") != 0; });
+    std::vector<const char*> interleaved;
+    for (const auto& token: tokens)
+        interleaved.push_back(token.c_str());
+    cl->parse(static_cast<int>(interleaved.size()), interleaved.data());
+    if (cl->args().size() != 1000 || cl->get<long>('n') != 994)
+        throw std::runtime_error("test FAILED: interleaved positional arguments");
+    for (std::size_t no = 0; no < 1000; ++no) {
+        if (const std::string arg = "arg" + std::to_string(no); cl->args()[no] != arg || interleaved[no + 1] != arg)
+            throw std::runtime_error("test FAILED: interleaved positional arguments order");
+    }
+    if (!std::equal(options.begin(), options.end(), interleaved.begin() + 1001))
+        throw std::runtime_error("test FAILED: interleaved options order");
+
+    const char* argv_error[] = {"progname", "-q", "a", "-q", "b", "--bad", "c"};
+    if (cl->try_parse(7, argv_error) || std::string(argv_error[1]) != "a" || std::string(argv_error[2]) != "b" || std::string(argv_error[3]) != "-q"
+        || std::string(argv_error[4]) != "-q" || std::string(argv_error[5]) != "--bad" || std::string(argv_error[6]) != "c")
+        throw std::runtime_error("test FAILED: argv permutation after an error");
+}
+
+// ----------------------------------------------------------------------
+
+void test_handles()
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+    using command_line_arguments::CommandLineError;
+
+    auto cl = make_command_line_arguments(
+        Arg<std::string>('o', "output", "-", Help()),
+        Arg<int>('n', "number", 0, Help()),
+        Arg<Count>('v', "verbose", Count(), Help())
+                                          );
+    const auto [h_output, h_number, h_verbose] = cl->handles();
+    const char* argv[] = {"progname", "-vv", "--output=out", "-n", "17"};
+    cl->parse(std::end(argv) - std::begin(argv), argv);
+    if (cl->get(h_output) != "out" || cl->get<int>(h_number) != 17 || std::size_t(cl->get(h_verbose)) != 2)
+        throw std::runtime_error("test FAILED: get() by handle");
+    if (&cl->get(h_number) != &cl->get<int>("number") || &cl->get(h_number) != &cl->get<int>('n'))
+        throw std::runtime_error("test FAILED: get() by handle and by name differ");
+    try {
+        cl->get<long>("number");
+        throw std::runtime_error("test FAILED: get() with wrong type accepted");
+    }
+    catch (CommandLineError&) {
+    }
+    try {
+        cl->get<int>('x');
+        throw std::runtime_error("test FAILED: get() of unknown option accepted");
+    }
+    catch (CommandLineError&) {
+    }
+
+    const auto& [output, number, verbose] = cl->result().values();
+    if (output != "out" || number != 17 || &cl->result().values().get<1>() != &cl->get(h_number) || &command_line_arguments::get<2>(cl->result().values()) != &cl->get(h_verbose))
+        throw std::runtime_error("test FAILED: values()");
+    const char* argv2[] = {"progname", "-v"};
+    cl->parse(std::end(argv2) - std::begin(argv2), argv2);
+    if (cl->get(h_output) != "-" || cl->get(h_number) != 0 || std::size_t(cl->get(h_verbose)) != 1)
+        throw std::runtime_error("test FAILED: values of the previous parse not reset");
+}
+
+// ----------------------------------------------------------------------
+
+void test_response_files()
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+    using command_line_arguments::ResponseFiles;
+
+    const std::string quoted_file = "/tmp/command-line-arguments-test-quoted.rsp", nested_file = "/tmp/command-line-arguments-test-nested.rsp", null_file = "/tmp/command-line-arguments-test-null.rsp";
+    std::ofstream(quoted_file) << "file1 --number 12\n  -v 'file 2' \"file\\\"3\" file\\ 4 --output=\"out put\" @" << nested_file << "\n";
+    std::ofstream(nested_file) << "-v nested";
+    std::ofstream(null_file, std::ios::binary) << std::string("-v\0null 1\0--number=13\0\0null\n2", 29);
+
+    auto test_file = [](ResponseFiles mode, const std::string& filename, const char* expected) {
+        auto cl = make_command_line_arguments(
+            Arg<std::string>('o', "output", "-", Help()),
+            Arg<int>('n', "number", 0, Help()),
+            Arg<Count>('v', "verbose", Count(), Help())
+                                              );
+        cl->response_files(mode);
+        const std::string file_arg = "@" + filename;
+        const char* argv[] = {"progname", "first", file_arg.c_str(), "last", "-vn", "14"};
+        cl->parse(std::end(argv) - std::begin(argv), argv);
+        std::stringstream report;
+        cl->report(report);
+        if (report.str() != expected) {
+            std::cerr << report.str() << std::endl << expected << std::endl;
+            throw std::runtime_error("test FAILED: response files");
+        }
+    };
+    test_file(ResponseFiles::quoted, quoted_file, "output=out put number=14 verbose=Count(3)\nARGS (7): first file1 file 2 file\"3 file 4 nested last");
+    test_file(ResponseFiles::null_separated, null_file, "output=- number=14 verbose=Count(2)\nARGS (4): first null 1 null\n2 last");
+    test_file(ResponseFiles::off, null_file, "output=- number=14 verbose=Count(1)\nARGS (3): first @/tmp/command-line-arguments-test-null.rsp last");
+    std::remove(quoted_file.c_str());
+    std::remove(nested_file.c_str());
+    std::remove(null_file.c_str());
+}
+
+// ----------------------------------------------------------------------
+
+void test_streaming()
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::CommandLineError;
+
+    auto cl = make_command_line_arguments(
+        Arg<int>('n', "number", 0, Help()),
+        Arg<bool>('q', "quiet", false, Help())
+                                          );
+    const char* argv[] = {"progname", "a1", "-n", "5", "a2", "-q", "a3", "a4", "a5"};
+    const int argc = std::end(argv) - std::begin(argv);
+
+    std::string args;
+    cl->parse(argc, argv, [&args](std::string_view arg) { args.append(arg).push_back(' '); });
+    if (args != "a1 a2 a3 a4 a5 " || !cl->args().empty() || cl->get<int>('n') != 5 || std::string(argv[1]) != "a1")
+        throw std::runtime_error("test FAILED: streaming parse: " + args);
+
+    std::vector<std::size_t> batches;
+    auto batcher = command_line_arguments::make_arg_batches(2, [&batches](std::vector<std::string_view>&& batch) { batches.push_back(batch.size()); });
+    cl->parse(argc, argv, batcher);
+    batcher.flush();
+    if (batches != std::vector<std::size_t>{2, 2, 1})
+        throw std::runtime_error("test FAILED: streaming parse with batches");
+
+    cl->min_max(1, 2);
+    std::size_t calls = 0;
+    try {
+        cl->parse(argc, argv, [&calls](std::string_view) { ++calls; });
+        throw std::runtime_error("test FAILED: streaming parse accepted too many arguments");
+    }
+    catch (CommandLineError&) {
+        if (calls != 2)
+            throw std::runtime_error("test FAILED: streaming parse did not stop at the maximum number of arguments");
+    }
+
+      // unquoted copies of streamed response file arguments are released after the callback, option values are kept
+    const std::string response_file = "/tmp/command-line-arguments-test-streaming.rsp";
+    std::ofstream(response_file) << "'quoted argument number one' \"quoted argument number two\" --output='quoted output file name'\n";
+    auto spec = command_line_arguments::make_specification(Arg<std::string_view>('o', "output", "-", Help()));
+    spec.response_files(command_line_arguments::ResponseFiles::quoted);
+    auto result = spec.make_result<command_line_arguments::CollectStatistics>();
+    const std::string file_arg = "@" + response_file;
+    const char* file_argv[] = {"progname", file_arg.c_str()};
+    std::vector<std::string> streamed;
+    spec.parse(2, file_argv, result, [&streamed](std::string_view arg) { streamed.emplace_back(arg); });
+    if (streamed != std::vector<std::string>{"quoted argument number one", "quoted argument number two"} || result.get<std::string_view>("output") != "quoted output file name"
+        || result.statistics().allocations() != 1)
+        throw std::runtime_error("test FAILED: streaming parse of quoted response file arguments");
+    std::vector<std::string_view> kept;
+    auto kept_batches = command_line_arguments::make_arg_batches(10, [&kept](std::vector<std::string_view>&& batch) { kept = std::move(batch); });
+    spec.parse(2, file_argv, result, kept_batches);
+    kept_batches.flush();
+    if (kept != std::vector<std::string_view>{"quoted argument number one", "quoted argument number two"} || result.statistics().allocations() != 4)
+        throw std::runtime_error("test FAILED: streaming parse of quoted response file arguments into batches");
+    std::remove(response_file.c_str());
+}
+
+// ----------------------------------------------------------------------
+
+void test_concurrent_parse()
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+
+    const auto spec = command_line_arguments::make_specification(
+        Arg<std::string>('o', "output", "-", Help()),
+        Arg<long>('n', "number", 0L, Help()),
+        Arg<Count>('v', "verbose", Count(), Help())
+                                                                 );
+    const auto [h_output, h_number, h_verbose] = spec.handles();
+    std::vector<std::thread> threads;
+    std::vector<std::string> failures(4);
+    for (std::size_t thread_no = 0; thread_no < failures.size(); ++thread_no) {
+        threads.emplace_back([&spec, &failure = failures[thread_no], thread_no, h_output = h_output, h_number = h_number, h_verbose = h_verbose]() {
+            auto result = spec.make_result();
+            for (long iteration = 0; iteration < 1000 && failure.empty(); ++iteration) {
+                const std::string output = "out-" + std::to_string(thread_no), number = std::to_string(iteration);
+                const char* argv[] = {"progname", "-v", "--output", output.c_str(), "arg", "-n", number.c_str(), (thread_no % 2) ? "-v" : "-"};
+                spec.parse(std::end(argv) - std::begin(argv), argv, result);
+                const std::size_t verbose = result.get(h_verbose), args = result.args().size();
+                if (result.get(h_output) != output || result.get(h_number) != iteration || verbose != 1 + (thread_no % 2) || args != 2 - (thread_no % 2))
+                    failure = "thread " + std::to_string(thread_no) + " iteration " + std::to_string(iteration);
+            }
+        });
+    }
+    for (auto& thread: threads)
+        thread.join();
+    for (const auto& failure: failures) {
+        if (!failure.empty())
+            throw std::runtime_error("test FAILED: concurrent parse: " + failure);
+    }
+}
+
+// ----------------------------------------------------------------------
+
+void test_batch()
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+    using command_line_arguments::PrintHelp;
+
+    const auto spec = command_line_arguments::make_specification(
+        Arg<std::string>('o', "output", "-", Help()),
+        Arg<long>('n', "number", 0L, Help()),
+        Arg<bool>('f', "flag", false, Help()),
+        Arg<Count>('v', "verbose", Count(), Help()),
+        Arg<PrintHelp>('h', "help", "usage", Help())
+                                                                 );
+    const auto [h_output, h_number, h_flag, h_verbose, h_help] = spec.handles();
+    const std::vector<std::string> lines{
+        "prog -n 1 a b",
+        "prog --output 'x y' -vv",
+        "prog -n not-a-number c",
+        "prog -f \"c d\" -",
+        "prog -h",
+        "prog",
+        "prog -v -n 7 last",
+    };
+    const auto result = command_line_arguments::parse_batch(spec, lines, 3, 2);
+    if (result.size() != lines.size())
+        throw std::runtime_error("test FAILED: batch size");
+    const auto& numbers = result.column(h_number);
+    const auto& outputs = result.column<std::string>("output");
+    const auto& flags = result.column(h_flag);
+    const auto& verbose = result.column<Count>('v');
+    if (numbers != std::vector<long>{1, 0, 0, 0, 0, 0, 7} || outputs[1] != "x y" || outputs[6] != "-" || flags[3] != 1 || flags[0] != 0 || static_cast<std::size_t>(verbose[1]) != 2 || static_cast<std::size_t>(verbose[6]) != 1)
+        throw std::runtime_error("test FAILED: batch columns");
+    if (result.errors().size() != 2 || result.errors()[0].first != 2 || result.errors()[1].first != 4 || result.valid()[2] || result.valid()[4] || !result.valid()[5])
+        throw std::runtime_error("test FAILED: batch errors");
+    if (result.arg_offsets() != std::vector<std::size_t>{0, 2, 2, 2, 4, 4, 4, 5})
+        throw std::runtime_error("test FAILED: batch arg offsets");
+    const auto args3 = result.args(3);
+    if (args3.size() != 2 || args3[0] != "c d" || args3[1] != "-" || result.args(6)[0] != "last" || !result.args(5).empty())
+        throw std::runtime_error("test FAILED: batch args");
+    try {
+        result.column<int>("number");
+        throw std::runtime_error("test FAILED: batch column of a wrong type");
+    }
+    catch (command_line_arguments::CommandLineError&) {
+    }
+
+      // views into a response file of a row must outlive parsing of the next rows
+    const std::string response_file = "/tmp/command-line-arguments-test-batch.rsp";
+    std::ofstream(response_file) << "--name from-file 'quoted arg' plain\n";
+    auto file_spec = command_line_arguments::make_specification(Arg<std::string_view>("name", "", Help()));
+    file_spec.response_files(command_line_arguments::ResponseFiles::quoted);
+    const std::vector<std::string> file_lines{"prog @" + response_file, "prog --name line x", "prog @" + response_file};
+    const auto file_result = command_line_arguments::parse_batch(file_spec, file_lines, 1, 2);
+    std::remove(response_file.c_str());
+    const auto& names = file_result.column<std::string_view>("name");
+    if (!file_result.errors().empty() || names[0] != "from-file" || names[1] != "line" || names[2] != "from-file" || file_result.args(0).size() != 2
+        || file_result.args(0)[0] != "quoted arg" || file_result.args(0)[1] != "plain" || file_result.args(2)[0] != "quoted arg")
+        throw std::runtime_error("test FAILED: batch with response files");
+}
+
+// ----------------------------------------------------------------------
+
+void test_parse_line()
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+
+    auto cl = make_command_line_arguments(
+        Arg<std::string_view>('o', "output", "-", Help()),
+        Arg<long>('n', "number", 0L, Help()),
+        Arg<Count>('v', "verbose", Count(), Help())
+                                          );
+    const std::string line = "  prog -v --output 'out file'\t\"a\\\"b\" -vn42 plain-argument-longer-than-thirty-two-chars \n";
+    cl->parse(line);
+    if (cl->result().program_name() != "prog" || cl->get<std::string_view>("output") != "out file" || cl->get<long>('n') != 42 || static_cast<std::size_t>(cl->get<Count>('v')) != 2)
+        throw std::runtime_error("test FAILED: parse(line) options");
+    if (cl->args().size() != 2 || cl->arg_view(0) != "a\"b" || cl->arg_view(1) != "plain-argument-longer-than-thirty-two-chars")
+        throw std::runtime_error("test FAILED: parse(line) arguments");
+    if (cl->arg_view(1).data() < line.data() || cl->arg_view(1).data() >= line.data() + line.size())
+        throw std::runtime_error("test FAILED: parse(line) copied an unquoted argument");
+    try {
+        cl->parse("prog 'unterminated");
+        throw std::runtime_error("test FAILED: parse(line) accepted unterminated quote");
+    }
+    catch (command_line_arguments::CommandLineError&) {
+    }
+}
+
+// ----------------------------------------------------------------------
+
+  // tokens of aLine or {"<error>"}
+static std::vector<std::string> split_line(const std::string& aLine)
+{
+    std::deque<std::string> unquoted;
+    command_line_arguments::ResponseFileTokenizer tokenizer(aLine, command_line_arguments::ResponseFiles::quoted, unquoted);
+    std::vector<std::string> tokens;
+    for (std::string_view token; tokenizer.next(token); )
+        tokens.emplace_back(token);
+    if (!tokenizer.unterminated().empty())
+        tokens.assign(1, "<error>");
+    return tokens;
+}
+
+void test_shell_conformance()
+{
+    const std::pair<std::string, std::vector<std::string>> cases[] = {
+        {"", {}},
+        {" \t\n ", {}},
+        {"a b\tc\nd", {"a", "b", "c", "d"}},
+        {"'' \"\"", {"", ""}},
+        {"a'b c'd", {"ab cd"}},
+        {"'a\\b'", {"a\\b"}},
+        {"\"a\\b\\\\c\\\"d\\$e\\`f\"", {"a\\b\\c\"d$e`f"}},
+        {"a\\ b \\'c", {"a b", "'c"}},
+        {"a\\\nb", {"ab"}},
+        {"\"a\\\nb\"", {"ab"}},
+        {"\"a\nb\"", {"a\nb"}},
+        {"a\\", {"a\\"}},
+        {"'a", {"<error>"}},
+        {"\"a\\\"", {"<error>"}},
+        {"abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz0123456789'x y'", {"abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz0123456789x y"}},
+    };
+    for (const auto& [line, expected]: cases) {
+        if (split_line(line) != expected)
+            throw std::runtime_error("test FAILED: shell conformance: " + line);
+    }
+
+#if __has_include(<unistd.h>)
+      // random lines compared with /bin/sh splitting them using eval "set -- <line>",
+      // chars that trigger expansions are not used
+    std::mt19937 generator(20151);
+    const char alphabet[] = "ab  \t'\"\\-";
+    std::uniform_int_distribution<std::size_t> char_no(0, sizeof(alphabet) - 2), run(0, 40), length(0, 80);
+    std::vector<std::string> lines(2000);
+    const std::string script_name = "/tmp/command-line-arguments-test-shell.sh";
+    {
+        std::ofstream script(script_name);
+        for (auto& line: lines) {
+            for (std::size_t size = length(generator); line.size() < size; ) {
+                const char ch = alphabet[char_no(generator)];
+                line.append(ch == '-' ? run(generator) : 1, ch == '-' ? 'x' : ch);
+            }
+            std::string quoted;
+            for (char ch: line)
+                quoted.append(ch == '\'' ? std::string("'\\''") : std::string(1, ch));
+            script << "L='" << quoted << "'; (eval \"set -- $L\" && printf '%s\\036' \"$#\" \"$@\") 2>/dev/null || printf 'E\\036'; printf '\\037'\n";
+        }
+    }
+    std::FILE* shell = popen(("/bin/sh " + script_name).c_str(), "r");
+    if (shell == nullptr)
+        throw std::runtime_error("test FAILED: shell conformance: cannot run /bin/sh");
+    std::string output;
+    for (int ch = std::fgetc(shell); ch != EOF; ch = std::fgetc(shell))
+        output.push_back(static_cast<char>(ch));
+    pclose(shell);
+    std::remove(script_name.c_str());
+
+    std::size_t pos = 0;
+    for (const auto& line: lines) {
+        const std::size_t end = output.find('\037', pos);
+        if (end == std::string::npos)
+            throw std::runtime_error("test FAILED: shell conformance: unexpected shell output");
+        std::vector<std::string> fields;
+        for (std::size_t field_end; (field_end = output.find('\036', pos)) < end; pos = field_end + 1)
+            fields.push_back(output.substr(pos, field_end - pos));
+        pos = end + 1;
+        const std::vector<std::string> reference = fields.at(0) == "E" ? std::vector<std::string>{"<error>"} : std::vector<std::string>(fields.begin() + 1, fields.end());
+        if (split_line(line) != reference)
+            throw std::runtime_error("test FAILED: shell conformance, differs from /bin/sh: " + line);
+    }
+#endif
+}
+
+// ----------------------------------------------------------------------
+
+void test_try_parse()
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+    using command_line_arguments::PrintHelp;
+    using command_line_arguments::ParseErrorCode;
+
+    auto cl = make_command_line_arguments(
+        Arg<std::string_view>('o', "output", "-", Help()),
+        Arg<long>('n', "number", 0L, Help()),
+        Arg<Count>('v', "verbose", Count(), Help()),
+        Arg<PrintHelp>('h', "help", "Usage: {progname} <file>", Help())
+                                          );
+    cl->min_max(0, 1);
+    struct Case { std::vector<const char*> argv; ParseErrorCode code; std::size_t token_no; std::size_t option; const char* text; const char* message; };
+    const Case cases[] = {
+        {{"prog", "-v", "--number", "x1"}, ParseErrorCode::invalid_value, 3, 1, "x1", "Cannot parse \"x1\" as long"},
+        {{"prog", "-vn12z"}, ParseErrorCode::invalid_value, 1, 1, "12z", "Cannot parse \"12z\" as long"},
+        {{"prog", "arg", "--unknown=1"}, ParseErrorCode::unrecognized_long_option, 2, std::size_t(-1), "--unknown=1", "Unrecognized long option --unknown=1"},
+        {{"prog", "-vx"}, ParseErrorCode::unrecognized_short_option, 1, std::size_t(-1), "x", "Unrecognized short option -x"},
+        {{"prog", "-v", "--output"}, ParseErrorCode::missing_value, 2, 0, "--output", "Switch --output requires a parameter, but end of command line arguments reached"},
+        {{"prog", "-vo"}, ParseErrorCode::missing_value, 1, 0, "o", "Switch -o requires a parameter, but end of command line arguments reached"},
+        {{"prog", "a", "-v", "b"}, ParseErrorCode::too_many_arguments, 3, std::size_t(-1), "b", "Too many arguments provided"},
+        {{"prog", "-vh", "a"}, ParseErrorCode::help_requested, 1, 3, "-vh", "Help requested"},
+    };
+    for (const auto& test_case: cases) {
+        std::vector<const char*> argv = test_case.argv;
+        const std::size_t allocations_before = sAllocations;
+        const auto status = cl->try_parse(static_cast<int>(argv.size()), argv.data());
+        if (sAllocations != allocations_before)
+            throw std::runtime_error(std::string("test FAILED: try_parse allocated for ") + test_case.message);
+        if (status || status.error().code() != test_case.code || status.error().token_no() != test_case.token_no || status.error().option() != test_case.option
+            || status.error().text() != test_case.text || status.error().message() != test_case.message)
+            throw std::runtime_error(std::string("test FAILED: try_parse: ") + (status ? std::string("succeeded") : status.error().message()) + " expected: " + test_case.message);
+    }
+
+    const char* argv[] = {"prog", "-v", "file"};
+    if (!cl->try_parse(3, argv) || cl->arg_view(0) != "file")
+        throw std::runtime_error("test FAILED: try_parse of a valid command line");
+    if (const auto status = cl->try_parse("prog -n 1 'unterminated"); status || status.error().code() != ParseErrorCode::unterminated_quote || status.error().token_no() != 3)
+        throw std::runtime_error("test FAILED: try_parse of unterminated quote");
+    if (const auto status = cl->try_parse("prog @/nonexistent/file"); !status || cl->arg_view(0) != "@/nonexistent/file")
+        throw std::runtime_error("test FAILED: try_parse with response files off");
+    cl->response_files(command_line_arguments::ResponseFiles::quoted);
+    if (const auto status = cl->try_parse("prog @/nonexistent/file"); status || status.error().code() != ParseErrorCode::response_file_unreadable
+        || status.error().message().find("Cannot open response file /nonexistent/file: ") != 0)
+        throw std::runtime_error("test FAILED: try_parse of nonexistent response file");
+
+    const char* help_argv[] = {"prog", "--help"};
+    if (const auto status = cl->try_parse(2, help_argv); status || status.error().code() != ParseErrorCode::help_requested) {
+        throw std::runtime_error("test FAILED: try_parse of help request");
+    }
+    else {
+        std::ostringstream help;
+        cl->print_help(help, status.error());
+        if (help.str().find("Usage: prog <file>") != 0)
+            throw std::runtime_error("test FAILED: print_help for help request: " + help.str());
+    }
+}
+
+// ----------------------------------------------------------------------
+
+template <typename T> static void test_conversion(const char* aValue, command_line_arguments::ParseErrorCode aCode, T aExpected = T())
+{
+    T value{};
+    const auto code = command_line_arguments::_from_chars(aValue, value);
+    if (code != aCode || (code == command_line_arguments::ParseErrorCode::none && value != aExpected))
+        throw std::runtime_error(std::string("test FAILED: conversion of \"") + aValue + "\" to " + command_line_arguments::_arg_type_name<T>());
+}
+
+void test_numeric_conversion()
+{
+    using command_line_arguments::ParseErrorCode;
+    constexpr auto none = ParseErrorCode::none, invalid = ParseErrorCode::invalid_value, out_of_range = ParseErrorCode::value_out_of_range;
+
+    test_conversion<int>("42", none, 42);
+    test_conversion<int>(" -17", none, -17);
+    test_conversion<int>("+8", none, 8);
+    test_conversion<int>("0x1F", none, 31);
+    test_conversion<int>("-0x10", none, -16);
+    test_conversion<int>("017", none, 15);
+    test_conversion<int>("0", none, 0);
+    test_conversion<int>("-2147483648", none, std::numeric_limits<int>::min());
+    test_conversion<int>("2147483647", none, std::numeric_limits<int>::max());
+    test_conversion<int>("2147483648", out_of_range);
+    test_conversion<int>("-2147483649", out_of_range);
+    test_conversion<int>("99999999999999999999999", out_of_range);
+    test_conversion<int>("", invalid);
+    test_conversion<int>("-", invalid);
+    test_conversion<int>("--1", invalid);
+    test_conversion<int>("+-1", invalid);
+    test_conversion<int>("12x", invalid);
+    test_conversion<int>("08", invalid);
+    test_conversion<int>("0x", invalid);
+    test_conversion<int>("1 ", invalid);
+    test_conversion<unsigned>("4294967295", none, 4294967295U);
+    test_conversion<unsigned>("4294967296", out_of_range);
+    test_conversion<unsigned>("-1", out_of_range);
+    test_conversion<unsigned>("-0", none, 0U);
+    test_conversion<long long>("-9223372036854775808", none, std::numeric_limits<long long>::min());
+    test_conversion<unsigned long>("18446744073709551615", none, 18446744073709551615UL);
+    test_conversion<double>("1.5", none, 1.5);
+    test_conversion<double>("-2.5e3", none, -2500.0);
+    test_conversion<double>("+.25", none, 0.25);
+    test_conversion<double>("0x1p4", none, 16.0);
+    test_conversion<double>("1e999", out_of_range);
+    test_conversion<double>("1,5", invalid);
+    test_conversion<double>("abc", invalid);
+    test_conversion<float>("0.5", none, 0.5F);
+    test_conversion<float>("1e39", out_of_range);
+    test_conversion<long double>("-0.125", none, -0.125L);
+
+      // decimal point does not depend on locale
+    for (const char* locale: {"de_DE.UTF-8", "de_DE", "fr_FR.UTF-8"}) {
+        if (std::setlocale(LC_NUMERIC, locale) != nullptr) {
+            test_conversion<double>("1.5", none, 1.5);
+            test_conversion<double>("1,5", invalid);
+            std::setlocale(LC_NUMERIC, "C");
+            break;
+        }
+    }
+
+    auto cl = make_command_line_arguments(command_line_arguments::Arg<int>('n', "number", 0, command_line_arguments::Help()));
+    const char* argv[] = {"prog", "--number", "3000000000"};
+    if (const auto status = cl->try_parse(3, argv); status || status.error().code() != out_of_range || status.error().message() != "Value \"3000000000\" is out of range of int")
+        throw std::runtime_error("test FAILED: out of range option value");
+}
+
+// ----------------------------------------------------------------------
+
+void test_list_options()
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::ParseErrorCode;
+
+    auto cl = make_command_line_arguments(
+        Arg<std::vector<int>>('i', "ids", {7}, Help("ids")),
+        Arg<std::vector<std::string_view>>("names", {}, Help()).delimiter(':'),
+        Arg<std::vector<double>>('t', "thresholds", {}, Help())
+                                          );
+    const auto [h_ids, h_names, h_thresholds] = cl->handles();
+    const char* argv1[] = {"prog", "--ids=1,-2,0x3", "arg", "-i", "4", "--names", "a:b::c", "-t", "0.5,1e3"};
+    cl->parse(9, argv1);
+    if (cl->get(h_ids) != std::vector<int>{1, -2, 3, 4} || cl->get(h_names) != std::vector<std::string_view>{"a", "b", "", "c"} || cl->get(h_thresholds) != std::vector<double>{0.5, 1000.0} || cl->args().size() != 1)
+        throw std::runtime_error("test FAILED: list options");
+    std::ostringstream report;
+    cl->report(report);
+    if (report.str().find("ids=1,-2,3,4 names=a:b::c thresholds=0.5,1000") == std::string::npos)
+        throw std::runtime_error("test FAILED: list options report: " + report.str());
+    std::ostringstream help;
+    cl->print_help(help);
+    if (help.str().find("--ids=<int,...>") == std::string::npos)
+        throw std::runtime_error("test FAILED: list options help: " + help.str());
+
+    const char* argv2[] = {"prog", "--ids="};
+    cl->parse(2, argv2);
+    if (!cl->get(h_ids).empty())
+        throw std::runtime_error("test FAILED: empty list option");
+    const char* argv3[] = {"prog"};
+    cl->parse(1, argv3);
+    if (cl->get(h_ids) != std::vector<int>{7})
+        throw std::runtime_error("test FAILED: default of list option");
+
+    const char* argv4[] = {"prog", "-i", "1,x,3"};
+    if (const auto status = cl->try_parse(3, argv4); status || status.error().code() != ParseErrorCode::invalid_value || status.error().text() != "x" || status.error().message() != "Cannot parse \"x\" as int")
+        throw std::runtime_error("test FAILED: invalid element of list option");
+    const char* argv5[] = {"prog", "-i", "1,99999999999"};
+    if (const auto status = cl->try_parse(3, argv5); status || status.error().code() != ParseErrorCode::value_out_of_range || status.error().text() != "99999999999")
+        throw std::runtime_error("test FAILED: out of range element of list option");
+
+    std::string ids;
+    for (int id = 0; id < 100000; ++id)
+        ids.append(std::to_string(id)).push_back(',');
+    ids.pop_back();
+    const char* argv6[] = {"prog", "-i", ids.c_str()};
+    cl->parse(3, argv6);
+    if (cl->get(h_ids).size() != 100000 || cl->get(h_ids).capacity() != 100000 || cl->get(h_ids)[99999] != 99999)
+        throw std::runtime_error("test FAILED: long list option");
+}
+
+// ----------------------------------------------------------------------
+
+void test_lazy_conversion()
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+    using command_line_arguments::ParseErrorCode;
+
+    auto spec = command_line_arguments::make_specification(
+        Arg<int>('n', "number", 1, Help()),
+        Arg<std::string>('s', "string", "default", Help()),
+        Arg<double>('d', "double", 0.5, Help()),
+        Arg<Count>('v', "verbose", Count(), Help()),
+        Arg<std::vector<int>>('i', "ids", {}, Help())
+                                                           );
+    spec.conversion(command_line_arguments::Conversion::lazy);
+    const auto [h_number, h_string, h_double, h_verbose, h_ids] = spec.handles();
+    auto result = spec.make_result();
+
+    const std::string long_string(100, 'x');
+    const char* argv1[] = {"prog", "-n", "3", "-vn", "5", "--string", long_string.c_str(), "-d", "bad", "arg"};
+    const std::size_t allocations_before = sAllocations;
+    if (!spec.try_parse(10, argv1, result))
+        throw std::runtime_error("test FAILED: lazy parse");
+    if (sAllocations != allocations_before)
+        throw std::runtime_error("test FAILED: lazy parse converted std::string value");
+    if (result.get(h_number) != 5 || static_cast<std::size_t>(result.get(h_verbose)) != 1 || !result.get(h_ids).empty() || result.args().size() != 1)
+        throw std::runtime_error("test FAILED: lazy get");
+    if (result.get<std::string>("string") != long_string)
+        throw std::runtime_error("test FAILED: lazy get by name");
+    if (const auto status = result.validate_all(); status || status.error().code() != ParseErrorCode::invalid_value || status.error().token_no() != 8 || status.error().option() != h_double.index || status.error().text() != "bad")
+        throw std::runtime_error("test FAILED: lazy validate_all");
+    try {
+        result.get(h_double);
+        throw std::runtime_error("test FAILED: lazy get of invalid value");
+    }
+    catch (command_line_arguments::CommandLineError&) {
+    }
+
+    const char* argv2[] = {"prog", "-d", "bad", "-n", "bad2", "-i", "1,2"};
+    if (!spec.try_parse(7, argv2, result) || result.get(h_ids) != std::vector<int>{1, 2})
+        throw std::runtime_error("test FAILED: lazy parse 2");
+    if (const auto status = result.validate_all(); status || status.error().token_no() != 2)
+        throw std::runtime_error("test FAILED: lazy validate_all reports the earliest error");
+
+      // token_no is the position on the original command line, argv has been permuted since
+    const char* argv5[] = {"prog", "a", "-n", "x", "b"};
+    if (!spec.try_parse(5, argv5, result) || result.validate_all() || result.validate_all().error().token_no() != 3 || std::string(argv5[3]) != "-n")
+        throw std::runtime_error("test FAILED: lazy token_no of a permuted argv");
+
+      // an invalid earlier value of a repeated option is the error, as in eager mode
+    const char* argv4[] = {"prog", "-n", "x", "-n", "5"};
+    if (const auto status = spec.try_parse(5, argv4, result); !status || result.validate_all() || result.validate_all().error().token_no() != 2 || result.validate_all().error().text() != "x")
+        throw std::runtime_error("test FAILED: lazy earlier invalid value of a repeated option");
+    try {
+        result.get(h_number);
+        throw std::runtime_error("test FAILED: lazy get of an earlier invalid value");
+    }
+    catch (command_line_arguments::CommandLineError&) {
+    }
+    spec.conversion(command_line_arguments::Conversion::eager);
+    if (const auto status = spec.try_parse(5, argv4, result); status || status.error().token_no() != 2 || status.error().text() != "x")
+        throw std::runtime_error("test FAILED: eager earlier invalid value of a repeated option");
+    spec.conversion(command_line_arguments::Conversion::lazy);
+
+    const char* argv3[] = {"prog"};
+    if (!spec.try_parse(1, argv3, result) || !result.validate_all() || result.get(h_number) != 1 || result.get(h_string) != "default")
+        throw std::runtime_error("test FAILED: lazy defaults");
+}
+
+// ----------------------------------------------------------------------
+
+  // built at compile time, no code runs on startup
+constexpr auto sConstexprSpec = command_line_arguments::make_specification(
+    command_line_arguments::Arg<std::string_view>('o', "output", "-", command_line_arguments::Help("output file")),
+    command_line_arguments::Arg<int>('n', "number", 3, command_line_arguments::Help("number")),
+    command_line_arguments::Arg<double>("ratio", 0.5, command_line_arguments::Help()),
+    command_line_arguments::Arg<bool>('t', "trace", false, command_line_arguments::Help("trace")),
+    command_line_arguments::Arg<command_line_arguments::Count>('v', "verbose", command_line_arguments::Count(), command_line_arguments::Help()),
+    command_line_arguments::Arg<command_line_arguments::PrintHelp>('h', "help", "Usage: {progname} [options] <file>", command_line_arguments::Help("prints this help text"))
+                                                                           ).min_max(1, 2);
+
+static_assert(std::is_trivially_destructible<decltype(sConstexprSpec)>::value, "constexpr specification must be a literal type");
+static_assert(sConstexprSpec.get<1>().default_value() == 3 && sConstexprSpec.get<1>().long_name() == "number", "constexpr specification");
+
+  // names, help and usage are views, temporary strings would dangle
+static_assert(!std::is_constructible<command_line_arguments::Arg<int>, std::string, int, command_line_arguments::Help>::value, "temporary long name");
+static_assert(!std::is_constructible<command_line_arguments::Arg<int>, char, std::string, int, command_line_arguments::Help>::value, "temporary long name");
+static_assert(!std::is_constructible<command_line_arguments::Arg<int>, const std::string, int, command_line_arguments::Help>::value, "const temporary long name");
+static_assert(std::is_constructible<command_line_arguments::Arg<int>, const std::string&, int, command_line_arguments::Help>::value, "long name of an lvalue");
+static_assert(!std::is_constructible<command_line_arguments::Help, std::string>::value && std::is_constructible<command_line_arguments::Help, const char*>::value, "temporary help");
+static_assert(!std::is_constructible<command_line_arguments::PrintHelp, std::string>::value, "temporary usage");
+static_assert(!std::is_constructible<command_line_arguments::Help, const std::string>::value && !std::is_constructible<command_line_arguments::PrintHelp, const std::string>::value, "const temporary help");
+static_assert(std::is_constructible<command_line_arguments::Arg<std::string>, const char*, std::string, command_line_arguments::Help>::value, "std::string default");
+
+void test_constexpr_specification()
+{
+    const auto [h_output, h_number, h_ratio, h_trace, h_verbose, h_help] = sConstexprSpec.handles();
+
+    const std::size_t allocations_before = sAllocations;
+    auto result = sConstexprSpec.make_result();
+    const char* argv1[] = {"prog", "-vtn", "7", "--output=out", "--ratio", "0x1p-2", "file"};
+    if (!sConstexprSpec.try_parse(7, argv1, result))
+        throw std::runtime_error("test FAILED: constexpr specification parse");
+    if (sAllocations != allocations_before)
+        throw std::runtime_error("test FAILED: constexpr specification make_result()/parse allocated");
+    if (result.get(h_output) != "out" || result.get(h_number) != 7 || result.get(h_ratio) != 0.25 || !result.get(h_trace) || static_cast<std::size_t>(result.get(h_verbose)) != 1 || result.args().size() != 1)
+        throw std::runtime_error("test FAILED: constexpr specification values");
+
+    const char* argv2[] = {"prog", "--help"};
+    if (const auto status = sConstexprSpec.try_parse(2, argv2, result); status || status.error().code() != command_line_arguments::ParseErrorCode::help_requested || status.error().option() != h_help.index)
+        throw std::runtime_error("test FAILED: constexpr specification help request");
+    std::ostringstream help;
+    sConstexprSpec.print_help(help, "prog", sConstexprSpec.try_parse(2, argv2, result).error());
+    if (help.str().find("Usage: prog [options] <file>") != 0 || help.str().find("--output=<string>  -- output file") == std::string::npos)
+        throw std::runtime_error("test FAILED: constexpr specification help: " + help.str());
+
+    const char* argv3[] = {"prog"};
+    if (const auto status = sConstexprSpec.try_parse(1, argv3, result); status || status.error().code() != command_line_arguments::ParseErrorCode::too_few_arguments)
+        throw std::runtime_error("test FAILED: constexpr specification min_max");
+}
+
+// ----------------------------------------------------------------------
+
+void test_statistics()
+{
+    using command_line_arguments::Help;
+    using command_line_arguments::Arg;
+    using command_line_arguments::Count;
+    using command_line_arguments::CollectStatistics;
+    using command_line_arguments::ParseErrorCode;
+
+    const auto spec = command_line_arguments::make_specification(
+        Arg<int>('n', "number", 1, Help()),
+        Arg<double>("ratio", 1.0, Help()),
+        Arg<std::string>("name", std::string(), Help()),
+        Arg<Count>('v', "verbose", Count(), Help()),
+        Arg<bool>("unused", false, Help())
+                                                                 );
+    const auto [h_number, h_ratio, h_name, h_verbose, h_unused] = spec.handles();
+    auto result = spec.make_result<CollectStatistics>();
+
+    const std::string long_name(100, 'x');
+    const char* argv1[] = {"prog", "-n", "5", "--ratio=0.5", "-vv", "--name", long_name.c_str(), "arg"};
+    spec.parse(8, argv1, result);
+    const std::size_t allocations_before = sAllocations;
+    spec.parse(8, argv1, result);
+    if (sAllocations != allocations_before)
+        throw std::runtime_error("test FAILED: parse with statistics allocated");
+    const auto& statistics = result.statistics();
+    if (statistics.parses() != 2 || statistics.failed() != 0 || statistics.tokens() != 16 || statistics.allocations() != 1 || statistics.first_error().code() != ParseErrorCode::none)
+        throw std::runtime_error("test FAILED: statistics counters");
+    if (statistics.hits(h_number) != 2 || statistics.hits(h_verbose) != 4 || statistics.hits(h_unused) != 0 || statistics.conversions(h_ratio.index) != 2 || statistics.conversions(h_verbose.index) != 0)
+        throw std::runtime_error("test FAILED: statistics hits");
+
+    const char* argv2[] = {"prog", "-n", "x"};
+    if (spec.try_parse(3, argv2, result) || statistics.failed() != 1 || statistics.first_error().code() != ParseErrorCode::invalid_value
+        || statistics.first_error_parse() != 2 || statistics.first_error().token_no() != 2 || statistics.first_error().option() != h_number.index)
+        throw std::runtime_error("test FAILED: statistics first error");
+
+    std::ostringstream key_value, json;
+    statistics.print_key_value(key_value);
+    statistics.print_json(json);
+    if (key_value.str().find("parses=3 failed=1 tokens=19 ") != 0 || key_value.str().find(" first_error=invalid_value first_error_parse=2 first_error_token=2 first_error_option=--number ") == std::string::npos
+        || key_value.str().find(" hits.--number=3 hits.--ratio=2 hits.--name=2 hits.--verbose=4 hits.--unused=0 conversion_ns.int=") == std::string::npos || key_value.str().find(" conversions.string=2") == std::string::npos)
+        throw std::runtime_error("test FAILED: statistics key=value: " + key_value.str());
+    if (json.str().find("{\"parses\": 3, \"failed\": 1, \"tokens\": 19, ") != 0 || json.str().find("\"first_error\": {\"code\": \"invalid_value\", \"parse\": 2, \"token\": 2, \"option\": \"--number\"}") == std::string::npos
+        || json.str().find("\"hits\": {\"--number\": 3, \"--ratio\": 2, \"--name\": 2, \"--verbose\": 4, \"--unused\": 0}, \"conversions\": {\"int\": {\"count\": 3, \"ns\": ") == std::string::npos)
+        throw std::runtime_error("test FAILED: statistics json: " + json.str());
+
+      // per thread results, aggregated
+    auto other = spec.make_result<CollectStatistics>();
+    spec.parse(8, argv1, other);
+    other.statistics().merge(statistics);
+    if (other.statistics().parses() != 4 || other.statistics().hits(h_verbose) != 6 || other.statistics().first_error_parse() != 3)
+        throw std::runtime_error("test FAILED: statistics merge");
+    other.statistics().clear();
+    if (other.statistics().parses() != 0 || other.statistics().hits(h_verbose) != 0)
+        throw std::runtime_error("test FAILED: statistics clear");
+
+    auto cl = command_line_arguments::make_command_line_arguments<CollectStatistics>(Arg<int>('n', "number", 1, Help()), Arg<Count>('v', "verbose", Count(), Help()));
+    const char* argv3[] = {"prog", "-vn", "3"};
+    cl->parse(3, argv3);
+    if (cl->get<int>('n') != 3 || cl->statistics().parses() != 1 || cl->statistics().hits(1) != 1)
+        throw std::runtime_error("test FAILED: CommandLineArguments statistics");
+}
+
+// ----------------------------------------------------------------------
+
+  // abbreviations and completion are resolved by the compile time table
+static constexpr auto sAbbreviationSpec = command_line_arguments::make_specification(
+    command_line_arguments::Arg<command_line_arguments::Count>('v', "verbose", command_line_arguments::Count(), command_line_arguments::Help()),
+    command_line_arguments::Arg<bool>("verb", false, command_line_arguments::Help()),
+    command_line_arguments::Arg<std::string_view>("output", "-", command_line_arguments::Help()),
+    command_line_arguments::Arg<std::string_view>("outline", "", command_line_arguments::Help()),
+    command_line_arguments::Arg<int>("jobs", 1, command_line_arguments::Help()),
+    command_line_arguments::Arg<bool>('x', false, command_line_arguments::Help())
+                                                                                     );
+
+void test_abbreviations()
+{
+    using command_line_arguments::ParseErrorCode;
+
+    const auto [h_verbose, h_verb, h_output, h_outline, h_jobs, h_x] = sAbbreviationSpec.handles();
+    auto result = sAbbreviationSpec.make_result();
+    const char* argv1[] = {"prog", "--verbo", "--verb", "--outp=file", "--j", "4", "--outl", "line"};
+    if (!sAbbreviationSpec.try_parse(8, argv1, result) || static_cast<std::size_t>(result.get(h_verbose)) != 1 || !result.get(h_verb)
+        || result.get(h_output) != "file" || result.get(h_jobs) != 4 || result.get(h_outline) != "line")
+        throw std::runtime_error("test FAILED: abbreviations");
+
+    const char* argv2[] = {"prog", "--out=file"};
+    if (const auto status = sAbbreviationSpec.try_parse(2, argv2, result); status || status.error().code() != ParseErrorCode::ambiguous_long_option || status.error().text() != "--out=file"
+        || status.error().message() != "Ambiguous long option --out=file")
+        throw std::runtime_error("test FAILED: ambiguous abbreviation");
+    const char* argv3[] = {"prog", "--"};
+    if (const auto status = sAbbreviationSpec.try_parse(2, argv3, result); status || status.error().code() != ParseErrorCode::unrecognized_long_option)
+        throw std::runtime_error("test FAILED: -- is not an abbreviation");
+
+    auto spec = command_line_arguments::make_specification(command_line_arguments::Arg<int>("jobs", 1, command_line_arguments::Help()));
+    spec.abbreviations(false);
+    auto result2 = spec.make_result();
+    const char* argv4[] = {"prog", "--job", "2"};
+    if (const auto status = spec.try_parse(3, argv4, result2); status || status.error().code() != ParseErrorCode::unrecognized_long_option)
+        throw std::runtime_error("test FAILED: abbreviations off");
+
+    std::string names;
+    if (sAbbreviationSpec.complete("ou", [&names](std::string_view aName) { names.append(aName).append(" "); }) != 2 || names != "outline output ")
+        throw std::runtime_error("test FAILED: complete(): " + names);
+    const auto complete = [](std::vector<const char*> argv) {
+        std::ostringstream out;
+        if (!sAbbreviationSpec.complete(static_cast<int>(argv.size()), argv.data(), out))
+            return std::string("not a query");
+        return out.str();
+    };
+    if (complete({"prog", "--complete", "--ver"}) != "--verb\n--verbose\n" || complete({"prog", "--complete", "-"}) != "--jobs\n--outline\n--output\n--verb\n--verbose\n"
+        || complete({"prog", "--complete"}) != complete({"prog", "--complete", "-"}) || !complete({"prog", "--complete", "--jobs=", "--bad-option"}).empty()
+        || !complete({"prog", "--complete", "-x"}).empty() || complete({"prog", "--verb", "--complete"}) != "not a query")
+        throw std::runtime_error("test FAILED: complete query mode");
+}
+
+// ----------------------------------------------------------------------
+
+  // only the selected subcommand specification is made
+static std::size_t sSubcommandsMade = 0;
+
+static const auto& log_specification()
+{
+    using command_line_arguments::Arg;
+    using command_line_arguments::Help;
+    ++sSubcommandsMade;
+    static const auto spec = command_line_arguments::make_specification(Arg<int>('n', "max-count", -1, Help("number of commits"))).min_max(0, 0);
+    return spec;
+}
+
+void test_subcommands()
+{
+    using command_line_arguments::Arg;
+    using command_line_arguments::Help;
+    using command_line_arguments::Count;
+    using command_line_arguments::PrintHelp;
+    using command_line_arguments::Subcommand;
+    using command_line_arguments::ParseErrorCode;
+
+    const auto commands = command_line_arguments::make_subcommands(
+        Subcommand("clone", Help("clone a repository"), [] {
+            ++sSubcommandsMade;
+            return command_line_arguments::make_specification(Arg<int>("depth", 0, Help("history depth")), Arg<PrintHelp>('h', "help", "Usage: {progname} <repository> [<directory>]", Help())).min_max(1, 2);
+        }),
+        Subcommand("log", Help("show commits"), &log_specification));
+    auto cl = make_command_line_arguments(Arg<Count>('v', "verbose", Count(), Help()), Arg<std::string_view>('C', "", ".", Help("run in directory")));
+    cl->min_max(0, 0); // the subcommand name is not a global positional argument
+    const auto [h_verbose, h_directory] = cl->handles();
+
+    std::string report;
+    const auto on_command = [&report](std::string_view aName, const auto& aResult) {
+        report.append(aName);
+        for (std::size_t arg_no = 0; arg_no < aResult.args().size(); ++arg_no)
+            report.append(" ").append(aResult.arg_view(arg_no));
+        if (aName == "clone")
+            report.append(" depth=").append(std::to_string(aResult.template get<int>("depth")));
+        else
+            report.append(" n=").append(std::to_string(aResult.template get<int>("max-count")));
+    };
+
+    const char* argv1[] = {"tool", "-v", "-C", "src", "clone", "--depth", "1", "url", "dir"};
+    if (!cl->try_parse(9, argv1, commands, on_command) || report != "clone url dir depth=1" || sSubcommandsMade != 1
+        || static_cast<std::size_t>(cl->result().get(h_verbose)) != 1 || cl->result().get(h_directory) != "src" || !cl->result().args().empty())
+        throw std::runtime_error("test FAILED: subcommand clone: " + report);
+    report.clear();
+    const char* argv2[] = {"tool", "log", "-n", "3"};
+    if (!cl->try_parse(4, argv2, commands, on_command) || report != "log n=3" || sSubcommandsMade != 2 || static_cast<std::size_t>(cl->result().get(h_verbose)) != 0)
+        throw std::runtime_error("test FAILED: subcommand log: " + report);
+    report.clear();
+    cl->parse(4, argv2, commands, on_command);
+    if (report != "log n=3" || sSubcommandsMade != 3)
+        throw std::runtime_error("test FAILED: subcommand parse(): " + report);
+
+    const auto error = [&](std::vector<const char*> argv, ParseErrorCode aCode, std::size_t aTokenNo, std::string aMessage) {
+        const auto made = sSubcommandsMade;
+        const auto status = cl->try_parse(static_cast<int>(argv.size()), argv.data(), commands, on_command);
+        if (status || status.error().code() != aCode || status.error().token_no() != aTokenNo || status.error().message() != aMessage)
+            throw std::runtime_error("test FAILED: subcommand error: " + aMessage + (status ? std::string(" accepted") : " <-> " + status.error().message()));
+        return sSubcommandsMade - made;
+    };
+    if (error({"tool", "-v", "push"}, ParseErrorCode::unknown_subcommand, 2, "Unknown subcommand push") != 0
+        || error({"tool", "-v"}, ParseErrorCode::missing_subcommand, 2, "Subcommand expected") != 0
+        || error({"tool", "--bad", "clone", "url"}, ParseErrorCode::unrecognized_long_option, 1, "Unrecognized long option --bad") != 0
+        || error({"tool", "-v", "clone", "--bad"}, ParseErrorCode::unrecognized_long_option, 3, "Unrecognized long option --bad") != 1
+        || error({"tool", "clone"}, ParseErrorCode::too_few_arguments, 2, "Too few arguments provided") != 1
+        || error({"tool", "log", "extra"}, ParseErrorCode::too_many_arguments, 2, "Too many arguments provided") != 1
+        || error({"tool", "clone", "-h"}, ParseErrorCode::help_requested, 2, "Help requested") != 1)
+        throw std::runtime_error("test FAILED: subcommand errors made unselected subcommands");
+    const std::string response_file = "/tmp/command-line-arguments-test-subcommand.rsp";
+    std::ofstream(response_file) << "-v clone url\n";
+    cl->response_files(command_line_arguments::ResponseFiles::quoted);
+    const std::string file_arg = "@" + response_file;
+    const auto in_file = error({"tool", file_arg.c_str()}, ParseErrorCode::subcommand_in_response_file, 3, "Subcommand cannot be given in a response file: clone");
+    cl->response_files(command_line_arguments::ResponseFiles::off);
+    std::remove(response_file.c_str());
+    if (in_file != 0 || std::string(command_line_arguments::_error_code_name(ParseErrorCode::subcommand_in_response_file)) != "subcommand_in_response_file")
+        throw std::runtime_error("test FAILED: subcommand in a response file");
+
+    std::ostringstream help;
+    commands.print_help(help);
+    if (help.str() != "Commands:\n  clone  -- clone a repository\n  log  -- show commits\n" || commands.find("log") != 1 || commands.find("lo") != commands.npos)
+        throw std::runtime_error("test FAILED: subcommands help: " + help.str());
+    try {
+        command_line_arguments::make_subcommands(Subcommand("log", Help(), &log_specification), Subcommand("log", Help(), &log_specification));
+        throw std::runtime_error("test FAILED: duplicate subcommand accepted");
+    }
+    catch (command_line_arguments::CommandLineError&) {
+    }
+}
+
+// ----------------------------------------------------------------------